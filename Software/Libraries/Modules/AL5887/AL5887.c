@@ -7,8 +7,45 @@
 
 #include "AL5887.h"
 
+// RAM shadow of the brightness and LED registers, initialized with their power-up values
+static uint8_t AL5887_shadow[AL5887_SHADOW_SIZE] = {
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+// One bit per shadow register which was changed but not yet sent
+static uint8_t AL5887_dirty[(AL5887_SHADOW_SIZE + 7) / 8];
+
+static uint8_t AL5887_is_dirty(uint8_t index)
+{
+	return AL5887_dirty[index >> 3] & (1 << (index & 0x07));
+}
+
+static void AL5887_shadow_set(uint8_t index, uint8_t value)
+{
+	if (AL5887_shadow[index] != value)
+	{
+		AL5887_shadow[index] = value;
+		AL5887_dirty[index >> 3] |= (1 << (index & 0x07));	// Mark the register as changed
+	}
+}
+
+static void AL5887_shadow_written(uint8_t register_address, const uint8_t values[], uint8_t length)
+{
+	// Keep the shadow in line with registers written directly to the device
+	for (uint8_t i = 0; i < length; i++)
+	{
+		uint8_t index = (uint8_t)(register_address + i - AL5887_REGISTER_BRIGHTNESS_RGB00);
+		if (index < AL5887_SHADOW_SIZE)
+		{
+			AL5887_shadow[index] = values[i];
+			AL5887_dirty[index >> 3] &= ~(1 << (index & 0x07));
+		}
+	}
+}
+
 void AL5887_send_data(uint8_t register_address, uint8_t value)
 {
+	AL5887_shadow_written(register_address, &value, 1);
 	i2c_master_start();									// Start I2C communication
 	i2c_master_sendAddress(AL5887_I2C_ADDRESS, 0x00);	// Send device I2C address
 	i2c_master_sendChar(register_address);				// Send the register address
@@ -16,6 +53,19 @@ void AL5887_send_data(uint8_t register_address, uint8_t value)
 	i2c_master_stop();									// Stop I2C communication
 }
 
+void AL5887_send_burst(uint8_t register_address, const uint8_t values[], uint8_t length)
+{
+	AL5887_shadow_written(register_address, values, length);
+	i2c_master_start();									// Start I2C communication
+	i2c_master_sendAddress(AL5887_I2C_ADDRESS, 0x00);	// Send device I2C address
+	i2c_master_sendChar(register_address);				// Send the first register address
+	for (uint8_t i = 0; i < length; i++)
+	{
+		i2c_master_sendChar(values[i]);					// Auto-increment moves to the next register
+	}
+	i2c_master_stop();									// Stop I2C communication
+}
+
 void AL5887_start()
 {
 	AL5887_send_data(AL5887_REGISTER_DEVICE_CONFIG0, (1 << 6));	// Set the start bit in the device config
@@ -28,19 +78,102 @@ void AL5887_stop()
 
 void AL5887_set_global_brightness(uint8_t brightness)
 {
-	// Write the brightness value to each of the brightness registers for the RGB LEDs
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB00, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB01, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB02, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB03, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB04, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB05, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB06, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB07, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB08, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB09, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB10, brightness);
-	AL5887_send_data(AL5887_REGISTER_BRIGHTNESS_RGB11, brightness);
+	// Write the brightness value to all brightness registers for the RGB LEDs in one transaction
+	for (uint8_t i = 0; i < AL5887_BRIGHTNESS_COUNT; i++)
+	{
+		AL5887_shadow[i] = brightness;
+	}
+	AL5887_send_burst(AL5887_REGISTER_BRIGHTNESS_RGB00, AL5887_shadow, AL5887_BRIGHTNESS_COUNT);
+}
+
+void AL5887_set_bank_mode(uint16_t leds)
+{
+	uint8_t config[2] = { (uint8_t)leds, (uint8_t)(leds >> 8) & 0x0F };
+	AL5887_send_burst(AL5887_REGISTER_LED_CONFIG0, config, 2);
+}
+
+void AL5887_set_individual_mode()
+{
+	AL5887_set_bank_mode(0x0000);
+}
+
+void AL5887_set_bank_color(uint8_t a, uint8_t b, uint8_t c)
+{
+	uint8_t color[3] = { a, b, c };
+	AL5887_send_burst(AL5887_REGISTER_BANK_A_COLOR, color, 3);
+}
+
+void AL5887_set_bank_brightness(uint8_t brightness)
+{
+	AL5887_send_data(AL5887_REGISTER_BANK_BRIGHTNESS, brightness);
+}
+
+void AL5887_set_bank(uint16_t leds, uint8_t brightness, uint8_t a, uint8_t b, uint8_t c)
+{
+	// LED_CONFIG0 to BANK_C_COLOR are consecutive registers
+	uint8_t bank[6] = { (uint8_t)leds, (uint8_t)(leds >> 8) & 0x0F, brightness, a, b, c };
+	AL5887_send_burst(AL5887_REGISTER_LED_CONFIG0, bank, 6);
+}
+
+void AL5887_write_brightness(const uint8_t brightness[AL5887_BRIGHTNESS_COUNT])
+{
+	AL5887_send_burst(AL5887_REGISTER_BRIGHTNESS_RGB00, brightness, AL5887_BRIGHTNESS_COUNT);
+}
+
+void AL5887_write_leds(uint8_t start, const uint8_t *values, uint8_t n)
+{
+	if (start >= AL5887_LED_COUNT)
+	{
+		return;
+	}
+	if (n > AL5887_LED_COUNT - start)
+	{
+		n = AL5887_LED_COUNT - start; // Do not run past the last LED register
+	}
+	AL5887_send_burst(AL5887_BASE_REGISTER_VALUE_LEDS + start, values, n);
+}
+
+void AL5887_buffer_brightness(uint8_t rgb, uint8_t brightness)
+{
+	if (rgb < AL5887_BRIGHTNESS_COUNT)
+	{
+		AL5887_shadow_set(rgb, brightness);
+	}
+}
+
+void AL5887_buffer_led_brightness(uint8_t led, uint8_t brightness)
+{
+	if (led < AL5887_LED_COUNT)
+	{
+		AL5887_shadow_set(AL5887_BRIGHTNESS_COUNT + led, brightness);
+	}
+}
+
+void AL5887_flush()
+{
+	uint8_t index = 0;
+	while (index < AL5887_SHADOW_SIZE)
+	{
+		if (!AL5887_is_dirty(index))
+		{
+			index++;
+			continue;
+		}
+		
+		// Extend the range while the next changed register is close enough
+		uint8_t first = index;
+		uint8_t last = index;
+		for (uint8_t next = index + 1; next < AL5887_SHADOW_SIZE && next - last <= AL5887_FLUSH_MAX_GAP + 1; next++)
+		{
+			if (AL5887_is_dirty(next))
+			{
+				last = next;
+			}
+		}
+		
+		AL5887_send_burst(AL5887_REGISTER_BRIGHTNESS_RGB00 + first, &AL5887_shadow[first], last - first + 1);	// Clears the dirty bits
+		index = last + 1;
+	}
 }
 
 void AL5887_set_led_brightness(uint8_t led, uint8_t brightness)
@@ -73,23 +206,59 @@ void AL5887_set_led_to_off(uint8_t led)
 	AL5887_set_led_brightness(led, 0x00);	// Set brightness to zero
 }
 
+uint8_t AL5887_get_led_brightness(uint8_t led)
+{
+	if (led < AL5887_LED_COUNT)
+	{
+		return AL5887_shadow[AL5887_BRIGHTNESS_COUNT + led];
+	}
+	return 0x00;
+}
+
+void AL5887_change_led_brightness(uint8_t led, int16_t step)
+{
+	int16_t brightness = (int16_t)AL5887_get_led_brightness(led) + step;
+	
+	// Limit the new brightness to the register range
+	if (brightness < 0x00)
+	{
+		brightness = 0x00;
+	}
+	else if (brightness > 0xFF)
+	{
+		brightness = 0xFF;
+	}
+	AL5887_set_led_brightness(led, (uint8_t)brightness);
+}
+
 void AL5887_flip_led_state(uint8_t led)
+{
+	// Toggle the LED based on its cached state
+	if (AL5887_get_led_brightness(led))
+	{
+		AL5887_set_led_to_off(led);  // If on, turn off the LED
+	}
+	else
+	{
+		AL5887_set_led_to_on(led);   // If off, turn on the LED
+	}
+}
+
+void AL5887_resync()
 {
 	i2c_master_start();												// Start I2C communication
 	i2c_master_sendAddress(AL5887_I2C_ADDRESS, 0x00);				// Send device address for writing
-	i2c_master_sendChar(AL5887_BASE_REGISTER_VALUE_LEDS + led);		// Send address of Leds brightness
+	i2c_master_sendChar(AL5887_REGISTER_BRIGHTNESS_RGB00);			// Send address of the first shadowed register
 	i2c_master_start();												// Start a new I2C communication (Repeated Start)
 	i2c_master_sendAddress(AL5887_I2C_ADDRESS, 0x01);				// Send device address for reading
-	uint8_t current_state = i2c_master_receiveChar(0x00);			// Read the current state
-	i2c_master_stop();												// Stop I2C communication
-	
-	// Toggle the LED based on its current state
-	if (current_state)
+	for (uint8_t i = 0; i < AL5887_SHADOW_SIZE; i++)
 	{
-		AL5887_set_led_to_off(led);  // If on, turn off the LED
+		AL5887_shadow[i] = i2c_master_receiveChar(i < AL5887_SHADOW_SIZE - 1);	// NACK the last byte
 	}
-	else
+	i2c_master_stop();												// Stop I2C communication
+	
+	for (uint8_t i = 0; i < sizeof(AL5887_dirty); i++)
 	{
-		AL5887_set_led_to_on(led);   // If off, turn on the LED
+		AL5887_dirty[i] = 0x00;
 	}
 }
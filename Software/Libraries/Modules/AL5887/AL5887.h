@@ -30,6 +30,46 @@
 */
 #define AL5887_REGISTER_DEVICE_CONFIG1     0x01
 
+/**
+ * @def AL5887_AUTO_INCREMENT
+ * @brief Bit in AL5887_REGISTER_DEVICE_CONFIG1 which enables the register auto-increment.
+ * @note Set after power-up. Burst writes rely on it: every further byte of a transaction goes to the next register.
+*/
+#define AL5887_AUTO_INCREMENT              (1 << 3)
+
+/**
+ * @defgroup BankRegisters Bank Control Registers
+ * @brief Register addresses for controlling RGB LEDs together as a bank.
+ *
+ * RGB LEDs assigned to bank control ignore their own brightness and LED
+ * registers. Their three outputs are driven by the bank colour registers
+ * A, B and C, scaled by the bank brightness.
+ * The following options are available:
+ * - `AL5887_REGISTER_LED_CONFIG0`         (0x02): Bank control enable for RGB LED 0 to 7 (one bit each)
+ * - `AL5887_REGISTER_LED_CONFIG1`         (0x03): Bank control enable for RGB LED 8 to 11 (bits 0-3)
+ * - `AL5887_REGISTER_BANK_BRIGHTNESS`     (0x04): Brightness of the bank
+ * - `AL5887_REGISTER_BANK_A_COLOR`        (0x05): First output of every RGB LED in the bank
+ * - `AL5887_REGISTER_BANK_B_COLOR`        (0x06): Second output of every RGB LED in the bank
+ * - `AL5887_REGISTER_BANK_C_COLOR`        (0x07): Third output of every RGB LED in the bank
+ *
+ * @{
+ */
+
+#define AL5887_REGISTER_LED_CONFIG0        0x02
+#define AL5887_REGISTER_LED_CONFIG1        0x03
+#define AL5887_REGISTER_BANK_BRIGHTNESS    0x04
+#define AL5887_REGISTER_BANK_A_COLOR       0x05
+#define AL5887_REGISTER_BANK_B_COLOR       0x06
+#define AL5887_REGISTER_BANK_C_COLOR       0x07
+
+/** @} */
+
+/**
+ * @def AL5887_BANK_ALL
+ * @brief Mask which assigns all 12 RGB LEDs to bank control.
+*/
+#define AL5887_BANK_ALL                    0x0FFF
+
 
 /**
  * @defgroup BrighnessRegisters Brightness Registers for RGB LEDs
@@ -74,6 +114,32 @@
 */
 #define AL5887_BASE_REGISTER_VALUE_LEDS    0x14
 
+/**
+ * @def AL5887_BRIGHTNESS_COUNT
+ * @brief Number of brightness registers, one per RGB LED.
+*/
+#define AL5887_BRIGHTNESS_COUNT            12
+
+/**
+ * @def AL5887_LED_COUNT
+ * @brief Number of LED output registers.
+*/
+#define AL5887_LED_COUNT                   36
+
+/**
+ * @def AL5887_SHADOW_SIZE
+ * @brief Number of registers held in the RAM shadow (brightness and LED registers, 0x08-0x37).
+*/
+#define AL5887_SHADOW_SIZE                 (AL5887_BRIGHTNESS_COUNT + AL5887_LED_COUNT)
+
+/**
+ * @def AL5887_FLUSH_MAX_GAP
+ * @brief Maximum number of unchanged registers which AL5887_flush() rewrites to join two changed ranges.
+ * @note Rewriting an unchanged register costs one byte on the bus, a further transaction costs start, address,
+ *       register and stop. Up to two unchanged registers are therefore cheaper to resend than a new transaction.
+*/
+#define AL5887_FLUSH_MAX_GAP               2
+
 
 /**
 * @brief Starts the AL5887 device.
@@ -103,16 +169,133 @@ void AL5887_stop();
 */
 void AL5887_send_data(uint8_t register_address, uint8_t value);
 
+/**
+* @brief Sends data to consecutive registers of the AL5887 device.
+*
+* This function writes all values in a single I2C transaction. The
+* register auto-increment of the device stores each value in the
+* register following the previous one.
+*
+* @param[in] register_address The address of the first register to write to.
+* @param[in] values The values to write.
+* @param[in] length The number of values.
+*/
+void AL5887_send_burst(uint8_t register_address, const uint8_t values[], uint8_t length);
+
+/**
+* @brief Sets the brightness of all RGB LEDs at once.
+*
+* This function writes all 12 brightness registers in a single I2C transaction.
+*
+* @param[in] brightness The brightness values for RGB LED 0 to 11 (0-255).
+*/
+void AL5887_write_brightness(const uint8_t brightness[AL5887_BRIGHTNESS_COUNT]);
+
+/**
+* @brief Sets the brightness of consecutive LEDs at once.
+*
+* This function writes the LED registers in a single I2C transaction,
+* so a full frame of 36 LEDs is one transaction. LEDs beyond the
+* last one (35) are ignored.
+*
+* @param[in] start The index of the first LED to set (0-35).
+* @param[in] values The brightness values (0-255).
+* @param[in] n The number of LEDs to set.
+*/
+void AL5887_write_leds(uint8_t start, const uint8_t *values, uint8_t n);
+
 /**
 * @brief Sets the global brightness of the AL5887 device.
 *
 * This function sets the brightness for all available RGB LEDs by
-* writing the specified brightness value to each brightness register.
+* writing the specified brightness value to each brightness register
+* in a single I2C transaction.
 *
 * @param[in] brightness The brightness value to set (0-255).
 */
 void AL5887_set_global_brightness(uint8_t brightness);
 
+/**
+* @brief Assigns RGB LEDs to bank control.
+*
+* This function writes both LED configuration registers in a single
+* I2C transaction. RGB LEDs not in the mask return to individual control.
+*
+* @param[in] leds Bit mask of the RGB LEDs 0 to 11 to control by the bank, e.g. AL5887_BANK_ALL.
+*/
+void AL5887_set_bank_mode(uint16_t leds);
+
+/**
+* @brief Returns all RGB LEDs to individual control.
+*
+* The LEDs show their own brightness and LED registers again.
+*/
+void AL5887_set_individual_mode();
+
+/**
+* @brief Sets the colour of the bank.
+*
+* This function writes the three bank colour registers in a single I2C transaction.
+*
+* @param[in] a The value for the first output of every RGB LED in the bank (0-255).
+* @param[in] b The value for the second output of every RGB LED in the bank (0-255).
+* @param[in] c The value for the third output of every RGB LED in the bank (0-255).
+*/
+void AL5887_set_bank_color(uint8_t a, uint8_t b, uint8_t c);
+
+/**
+* @brief Sets the brightness of the bank.
+*
+* @param[in] brightness The brightness value to set (0-255).
+*/
+void AL5887_set_bank_brightness(uint8_t brightness);
+
+/**
+* @brief Assigns RGB LEDs to the bank and sets its colour and brightness.
+*
+* This function writes all bank registers in a single I2C transaction,
+* e.g. to change the colour of the whole matrix at once.
+*
+* @param[in] leds Bit mask of the RGB LEDs 0 to 11 to control by the bank.
+* @param[in] brightness The brightness of the bank (0-255).
+* @param[in] a The value for the first output of every RGB LED in the bank (0-255).
+* @param[in] b The value for the second output of every RGB LED in the bank (0-255).
+* @param[in] c The value for the third output of every RGB LED in the bank (0-255).
+*/
+void AL5887_set_bank(uint16_t leds, uint8_t brightness, uint8_t a, uint8_t b, uint8_t c);
+
+/**
+* @brief Sets the brightness of an RGB LED in the RAM shadow.
+*
+* This function only updates the shadow and marks the register as
+* changed if the value differs. Call AL5887_flush() to send all changes.
+*
+* @param[in] rgb The index of the RGB LED to configure (0-11).
+* @param[in] brightness The brightness value to set (0-255).
+*/
+void AL5887_buffer_brightness(uint8_t rgb, uint8_t brightness);
+
+/**
+* @brief Sets the brightness of a specific LED in the RAM shadow.
+*
+* This function only updates the shadow and marks the register as
+* changed if the value differs. Call AL5887_flush() to send all changes.
+*
+* @param[in] led The index of the LED to configure (0-35).
+* @param[in] brightness The brightness value to set (0-255).
+*/
+void AL5887_buffer_led_brightness(uint8_t led, uint8_t brightness);
+
+/**
+* @brief Sends all changed registers of the RAM shadow to the device.
+*
+* This function sends the changed registers as contiguous burst writes.
+* Changed registers separated by at most AL5887_FLUSH_MAX_GAP unchanged
+* ones are joined into one transaction. Nothing is sent if no register
+* changed since the last flush.
+*/
+void AL5887_flush();
+
 /**
 * @brief Sets the brightness of a specific LED.
 *
@@ -153,14 +336,45 @@ void AL5887_set_led_to_on(uint8_t led);
 */
 void AL5887_set_led_to_off(uint8_t led);
 
+/**
+* @brief Returns the brightness of a specific LED.
+*
+* This function returns the value from the RAM shadow without
+* accessing the bus. Use AL5887_resync() if the device may have
+* been changed from elsewhere.
+*
+* @param[in] led The index of the LED (0-35).
+* @return The brightness value of the LED (0-255), 0 for an invalid index.
+*/
+uint8_t AL5887_get_led_brightness(uint8_t led);
+
+/**
+* @brief Changes the brightness of a specific LED relative to its current value.
+*
+* This function adds the step to the cached brightness, limits the
+* result to 0-255 and writes it to the device. No register is read.
+*
+* @param[in] led The index of the LED to configure (0-35).
+* @param[in] step The change of the brightness (-255 to 255).
+*/
+void AL5887_change_led_brightness(uint8_t led, int16_t step);
+
 /**
 * @brief Toggles the state of a specific LED.
 *
-* This function reads the current state of the specified LED and toggles it
-* between on and off.
+* This function toggles the specified LED between on and off based on
+* the cached brightness. No register is read.
 *
 * @param[in] led The index of the LED to toggle (0-35).
 */
 void AL5887_flip_led_state(uint8_t led);
 
+/**
+* @brief Refreshes the RAM shadow from the device.
+*
+* This function reads all brightness and LED registers in a single
+* burst read. Changes which were buffered but not flushed are discarded.
+*/
+void AL5887_resync();
+
 #endif /* AL5887_H_ */
@@ -0,0 +1,238 @@
+/*
+* AL5887_animation.c
+*
+* Created: 19.10.2026 10:12:58
+*/
+
+#include "AL5887_animation.h"
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#define AL5887_TRACK_ACTIVE                (1 << 0)
+#define AL5887_TRACK_LOOP                  (1 << 1)
+
+struct AL5887_track
+{
+	const struct AL5887_keyframe *keyframes;
+	uint16_t elapsed_ms;	// Time since the previous keyframe
+	uint8_t count;
+	uint8_t index;			// Keyframe which is approached
+	uint8_t led;
+	uint8_t flags;
+};
+
+// Gamma 2.2: round(255 * (level / 255)^2.2)
+static const uint8_t AL5887_gamma_table[256] PROGMEM = {
+	  0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+	  1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+	  3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+	  6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+	 12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+	 20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+	 30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+	 42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+	 56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+	 73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+	 91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+	113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+	137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+	163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+	192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+	223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+static struct AL5887_track AL5887_tracks[AL5887_ANIMATION_TRACKS];
+static volatile uint8_t AL5887_ticks;
+static uint16_t AL5887_tick_remainder_us;
+
+#ifdef AL5887_ANIMATION_TIMER0
+ISR(TIMER0_COMP_vect)
+{
+	AL5887_animation_tick();
+}
+#endif
+
+uint8_t AL5887_gamma(uint8_t level)
+{
+	return pgm_read_byte(&AL5887_gamma_table[level]);
+}
+
+static struct AL5887_track *AL5887_find_track(uint8_t led)
+{
+	for (uint8_t i = 0; i < AL5887_ANIMATION_TRACKS; i++)
+	{
+		if ((AL5887_tracks[i].flags & AL5887_TRACK_ACTIVE) && AL5887_tracks[i].led == led)
+		{
+			return &AL5887_tracks[i];
+		}
+	}
+	return 0;
+}
+
+static uint8_t AL5887_track_level(const struct AL5887_track *track)
+{
+	const struct AL5887_keyframe *from = &track->keyframes[track->index - 1];
+	const struct AL5887_keyframe *to = &track->keyframes[track->index];
+	
+	// Position in the segment, 0-256
+	uint16_t t = (uint16_t)(((uint32_t)track->elapsed_ms << 8) / to->duration_ms);
+	
+	switch (to->easing)
+	{
+		case AL5887_EASING_EASE_IN_OUT:
+		t = (uint16_t)(((uint32_t)t * t * (768 - 2 * t)) >> 16);	// Smoothstep t^2 * (3 - 2t)
+		break;
+		
+		case AL5887_EASING_STEP:
+		t = 0;
+		break;
+	}
+	
+	return (uint8_t)(from->level + (((int32_t)to->level - from->level) * t >> 8));
+}
+
+static void AL5887_track_advance(struct AL5887_track *track, uint16_t ms)
+{
+	track->elapsed_ms += ms;
+	
+	// Pass all keyframes which were reached
+	while (track->elapsed_ms >= track->keyframes[track->index].duration_ms)
+	{
+		track->elapsed_ms -= track->keyframes[track->index].duration_ms;
+		if (track->index + 1 < track->count)
+		{
+			track->index++;
+		}
+		else if (track->flags & AL5887_TRACK_LOOP)
+		{
+			AL5887_buffer_led_brightness(track->led, AL5887_gamma(track->keyframes[0].level));
+			track->index = 1;
+		}
+		else
+		{
+			AL5887_buffer_led_brightness(track->led, AL5887_gamma(track->keyframes[track->index].level));
+			track->flags = 0;	// Track finished
+			return;
+		}
+	}
+	
+	AL5887_buffer_led_brightness(track->led, AL5887_gamma(AL5887_track_level(track)));
+}
+
+void AL5887_animation_init()
+{
+	for (uint8_t i = 0; i < AL5887_ANIMATION_TRACKS; i++)
+	{
+		AL5887_tracks[i].flags = 0;
+	}
+	AL5887_ticks = 0;
+	AL5887_tick_remainder_us = 0;
+	
+#ifdef AL5887_ANIMATION_TIMER0
+	TCCR0 = (1 << WGM01) | (1 << CS02) | (1 << CS00);	// CTC mode, prescaler 1024
+	OCR0 = AL5887_ANIMATION_TIMER0_TOP;
+	TIFR = (1 << OCF0);									// Clear a pending compare match
+	TIMSK |= (1 << OCIE0);								// Enable the compare match interrupt
+#endif
+}
+
+uint8_t AL5887_animation_play(uint8_t led, const struct AL5887_keyframe keyframes[], uint8_t count, uint8_t loop)
+{
+	if (led >= AL5887_LED_COUNT || count == 0)
+	{
+		return 0;
+	}
+	
+	struct AL5887_track *track = AL5887_find_track(led);
+	for (uint8_t i = 0; !track && i < AL5887_ANIMATION_TRACKS; i++)
+	{
+		if (!(AL5887_tracks[i].flags & AL5887_TRACK_ACTIVE))
+		{
+			track = &AL5887_tracks[i];
+		}
+	}
+	if (!track)
+	{
+		return 0;
+	}
+	
+	// A loop without any duration would never advance
+	uint8_t moving = 0;
+	for (uint8_t i = 1; i < count; i++)
+	{
+		if (keyframes[i].duration_ms)
+		{
+			moving = 1;
+		}
+	}
+	
+	AL5887_buffer_led_brightness(led, AL5887_gamma(keyframes[0].level));
+	if (!moving)
+	{
+		AL5887_buffer_led_brightness(led, AL5887_gamma(keyframes[count - 1].level));
+		track->flags = 0;
+		return 1;
+	}
+	
+	track->keyframes = keyframes;
+	track->count = count;
+	track->index = 1;
+	track->elapsed_ms = 0;
+	track->led = led;
+	track->flags = AL5887_TRACK_ACTIVE | (loop ? AL5887_TRACK_LOOP : 0);
+	return 1;
+}
+
+void AL5887_animation_stop(uint8_t led)
+{
+	struct AL5887_track *track = AL5887_find_track(led);
+	if (track)
+	{
+		track->flags = 0;
+	}
+}
+
+uint8_t AL5887_animation_is_running(uint8_t led)
+{
+	return AL5887_find_track(led) != 0;
+}
+
+void AL5887_animation_tick()
+{
+	if (AL5887_ticks < 0xFF)
+	{
+		AL5887_ticks++;
+	}
+}
+
+uint8_t AL5887_animation_poll()
+{
+	if (!AL5887_ticks)
+	{
+		return 0;
+	}
+	
+	uint8_t sreg = SREG;
+	cli();
+	uint8_t ticks = AL5887_ticks;
+	AL5887_ticks = 0;
+	SREG = sreg;
+	
+	// Convert the ticks to milliseconds and keep the fraction for the next frame
+	uint32_t elapsed_us = (uint32_t)ticks * AL5887_ANIMATION_TICK_US + AL5887_tick_remainder_us;
+	uint16_t ms = (uint16_t)(elapsed_us / 1000);
+	AL5887_tick_remainder_us = (uint16_t)(elapsed_us % 1000);
+	
+	for (uint8_t i = 0; i < AL5887_ANIMATION_TRACKS; i++)
+	{
+		if (AL5887_tracks[i].flags & AL5887_TRACK_ACTIVE)
+		{
+			AL5887_track_advance(&AL5887_tracks[i], ms);
+		}
+	}
+	
+	AL5887_flush();
+	return 1;
+}
@@ -0,0 +1,151 @@
+/*
+* AL5887_animation.h
+*
+* Created: 19.10.2026 10:12:41
+*/
+
+#ifndef AL5887_ANIMATION_H_
+#define AL5887_ANIMATION_H_
+
+#include "AL5887.h"
+
+/**
+* @def AL5887_ANIMATION_TIMER0
+* @brief Generates the frame tick with Timer0 in CTC mode.
+*
+* @note: The frame rate is F_CPU / 1024 / (AL5887_ANIMATION_TIMER0_TOP + 1), about 60 Hz at 12 MHz.
+* This claims Timer0 and its compare interrupt. Global interrupts have to be enabled with sei().
+* Without it, call AL5887_animation_tick() from an own timer interrupt and set AL5887_ANIMATION_TICK_US to its period.
+*
+* To enable, uncomment the following line:
+* @code
+* #define AL5887_ANIMATION_TIMER0
+* @endcode
+*/
+//#define AL5887_ANIMATION_TIMER0
+
+/**
+* @def AL5887_ANIMATION_TIMER0_TOP
+* @brief Compare value of Timer0 (0-255), 194 gives 60.1 frames per second at 12 MHz.
+* Can be set for the whole project, e.g. -DAL5887_ANIMATION_TIMER0_TOP=155.
+*/
+#ifndef AL5887_ANIMATION_TIMER0_TOP
+#define AL5887_ANIMATION_TIMER0_TOP        194
+#endif
+
+/**
+* @def AL5887_ANIMATION_TICK_US
+* @brief Duration of one frame tick in microseconds.
+* @note Set to the period of the own timer if AL5887_ANIMATION_TIMER0 is not used, e.g. -DAL5887_ANIMATION_TICK_US=10000.
+*/
+#ifndef AL5887_ANIMATION_TICK_US
+#define AL5887_ANIMATION_TICK_US           ((AL5887_ANIMATION_TIMER0_TOP + 1) * 1024UL * 1000UL / (F_CPU / 1000UL))
+#endif
+
+/**
+* @def AL5887_ANIMATION_TRACKS
+* @brief Maximum number of tracks running at the same time, each uses 8 bytes of SRAM.
+*/
+#define AL5887_ANIMATION_TRACKS            8
+
+/**
+* @defgroup AnimationEasing Easing of an animation segment
+* @brief Interpolation from the previous keyframe to the next one.
+*
+* The following options are available:
+* - `AL5887_EASING_LINEAR`      (0): Constant speed
+* - `AL5887_EASING_EASE_IN_OUT` (1): Slow start and end (smoothstep)
+* - `AL5887_EASING_STEP`        (2): Hold the previous level, then jump at the end of the segment
+*
+* @{
+*/
+
+#define AL5887_EASING_LINEAR               0
+#define AL5887_EASING_EASE_IN_OUT          1
+#define AL5887_EASING_STEP                 2
+
+/** @} */
+
+/**
+* @brief A point of an animation track.
+*
+* The level is linear in perceived brightness and passes the gamma table
+* before it is written to the LED.
+*/
+struct AL5887_keyframe
+{
+	uint16_t duration_ms;	/**< Time to reach this keyframe from the previous one, ignored for the first keyframe. */
+	uint8_t level;			/**< Perceived brightness (0-255). */
+	uint8_t easing;			/**< Interpolation from the previous keyframe, see @ref AnimationEasing. */
+};
+
+/**
+* @brief Initializes the animation engine.
+*
+* This function stops all tracks and, with AL5887_ANIMATION_TIMER0,
+* configures Timer0 to generate the frame tick.
+*/
+void AL5887_animation_init();
+
+/**
+* @brief Starts a keyframe track on a LED.
+*
+* The LED starts at the level of the first keyframe and reaches every
+* further keyframe after its duration. A track already running on the
+* LED is replaced. The keyframes are not copied and must stay valid
+* while the track runs.
+*
+* @param[in] led The index of the LED to animate (0-35).
+* @param[in] keyframes The keyframes of the track.
+* @param[in] count The number of keyframes (1-255).
+* @param[in] loop 1 to restart at the first keyframe after the last one, 0 to stop there.
+* @return 1 if the track was started, 0 if no track was free or a parameter is invalid.
+*/
+uint8_t AL5887_animation_play(uint8_t led, const struct AL5887_keyframe keyframes[], uint8_t count, uint8_t loop);
+
+/**
+* @brief Stops the track of a LED.
+*
+* The LED keeps its current brightness.
+*
+* @param[in] led The index of the LED (0-35).
+*/
+void AL5887_animation_stop(uint8_t led);
+
+/**
+* @brief Checks whether a track is running on a LED.
+*
+* @param[in] led The index of the LED (0-35).
+* @return 1 if a track is running, 0 otherwise.
+*/
+uint8_t AL5887_animation_is_running(uint8_t led);
+
+/**
+* @brief Counts a frame tick.
+*
+* This function only increments a counter. Call it from an own timer
+* interrupt, or enable AL5887_ANIMATION_TIMER0 to use Timer0.
+*/
+void AL5887_animation_tick();
+
+/**
+* @brief Advances all tracks and updates the LEDs.
+*
+* This function returns immediately if no frame tick occurred since the
+* last call. Otherwise it advances the tracks by the elapsed ticks and
+* flushes the changed registers with AL5887_flush(). Call it from the
+* main loop.
+*
+* @return 1 if a frame was processed, 0 otherwise.
+*/
+uint8_t AL5887_animation_poll();
+
+/**
+* @brief Applies the gamma correction to a perceived brightness.
+*
+* @param[in] level The perceived brightness (0-255).
+* @return The register value for the LED (0-255).
+*/
+uint8_t AL5887_gamma(uint8_t level);
+
+#endif /* AL5887_ANIMATION_H_ */
@@ -0,0 +1,315 @@
+/*
+ * ahrs.c
+ *
+ * Created: 19.10.2026 09:40:03
+ */
+
+#include "ahrs.h"
+#include "cordic.h"
+#include <stddef.h>
+
+/**
+ * @def AHRS_GYRO_FACTOR_250DPS
+ *
+ * rad per LSB of the gyroscope at +-250 dps, multiplied by 2^30 / 2: 250 / 2^15 * pi / 180 * 2^29.
+ */
+#define AHRS_GYRO_FACTOR_250DPS 71489UL
+
+/**
+ * @brief Multiply a 32-bit value with a 16-bit value and shift the product right.
+ * Only 16 x 16 bit multiplications are used, which the AVR does in hardware, and the result is exactly (a * b) >> shift.
+ *
+ * @param[in] a The 32-bit factor.
+ * @param[in] b The 16-bit factor.
+ * @param[in] shift Number of bits to shift the product right (at most 16).
+ * @return The shifted product.
+ */
+static inline int32_t ahrs_multiply(int32_t a, int16_t b, uint8_t shift)
+{
+    int32_t high = (int32_t)(int16_t)(a >> 16) * b;
+    int32_t low = (int32_t)(uint16_t)a * b;
+
+    return (high << (16 - shift)) + (low >> shift);
+}
+
+/**
+ * @brief Integer square root.
+ *
+ * @param[in] value The value.
+ * @return floor(sqrt(value))
+ */
+static uint16_t ahrs_sqrt(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint16_t)result;
+}
+
+/**
+ * @brief Limit a value to the range of int16_t.
+ *
+ * @param[in] value The value.
+ * @return The limited value.
+ */
+static int16_t ahrs_saturate(int32_t value)
+{
+    if (value > 32767)
+    {
+        return 32767;
+    }
+    if (value < -32767)
+    {
+        return -32767;
+    }
+    return (int16_t)value;
+}
+
+/**
+ * @brief Scale a vector to a length of 1.
+ *
+ * @param[in,out] vector The raw vector, replaced by the unit vector (Q15).
+ * @return 1 on success, 0 if the vector has a length of 0.
+ */
+static uint8_t ahrs_normalize(int16_t vector[3])
+{
+    int16_t scaled[3];
+    uint16_t largest = 0;
+    uint32_t sum = 0;
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        uint16_t value = (vector[i] < 0) ? -(int32_t)vector[i] : vector[i];
+        if (value > largest)
+        {
+            largest = value;
+        }
+        scaled[i] = vector[i];
+    }
+    if (largest == 0)
+    {
+        return 0;
+    }
+
+    // Bring the largest component to 2^13 - 2^14, so small vectors keep their precision
+    while (largest >= (1 << 14))
+    {
+        largest >>= 1;
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            scaled[i] >>= 1;
+        }
+    }
+    while (largest < (1 << 13))
+    {
+        largest <<= 1;
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            scaled[i] <<= 1;
+        }
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        sum += (int32_t)scaled[i] * scaled[i];
+    }
+
+    // A single division, the components are multiplied with the inverse length (Q29 / length)
+    uint32_t inverse = (1UL << 29) / ahrs_sqrt(sum);
+    if (inverse > 0xFFFF)
+    {
+        inverse = 0xFFFF;
+    }
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        vector[i] = ahrs_saturate(((int32_t)scaled[i] * (uint16_t)inverse) >> 14);
+    }
+    return 1;
+}
+
+/**
+ * @brief Calculate the rotation matrix from the sensor to the earth frame.
+ *
+ * @param[in] q The quaternion (Q15).
+ * @param[out] matrix The rotation matrix (Q14).
+ */
+static void ahrs_rotation_matrix(const int16_t q[4], int16_t matrix[3][3])
+{
+    int32_t q0q1 = (int32_t)q[0] * q[1];
+    int32_t q0q2 = (int32_t)q[0] * q[2];
+    int32_t q0q3 = (int32_t)q[0] * q[3];
+    int32_t q1q1 = (int32_t)q[1] * q[1];
+    int32_t q1q2 = (int32_t)q[1] * q[2];
+    int32_t q1q3 = (int32_t)q[1] * q[3];
+    int32_t q2q2 = (int32_t)q[2] * q[2];
+    int32_t q2q3 = (int32_t)q[2] * q[3];
+    int32_t q3q3 = (int32_t)q[3] * q[3];
+
+    // The products are Q30, twice the product shifted by 16 gives Q14
+    matrix[0][0] = (AHRS_ONE / 2 - (q2q2 + q3q3)) >> 15;
+    matrix[0][1] = (q1q2 - q0q3) >> 15;
+    matrix[0][2] = (q1q3 + q0q2) >> 15;
+    matrix[1][0] = (q1q2 + q0q3) >> 15;
+    matrix[1][1] = (AHRS_ONE / 2 - (q1q1 + q3q3)) >> 15;
+    matrix[1][2] = (q2q3 - q0q1) >> 15;
+    matrix[2][0] = (q1q3 - q0q2) >> 15;
+    matrix[2][1] = (q2q3 + q0q1) >> 15;
+    matrix[2][2] = (AHRS_ONE / 2 - (q1q1 + q2q2)) >> 15;
+}
+
+/**
+ * @brief Get the upper 16 bits of the quaternion.
+ *
+ * @param[in] ahrs The filter.
+ * @param[out] q The quaternion (Q15).
+ */
+static void ahrs_quaternion_q15(const struct ahrs *ahrs, int16_t q[4])
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        q[i] = ahrs_saturate(ahrs->q[i] >> 15);
+    }
+}
+
+void ahrs_init(struct ahrs *ahrs, uint8_t gyro_range, uint16_t sample_rate, uint16_t kp, uint8_t ki)
+{
+    uint32_t numerator = AHRS_GYRO_FACTOR_250DPS << (gyro_range & 0x03);
+    uint32_t rate_squared = (uint32_t)sample_rate * sample_rate;
+
+    ahrs->q[0] = AHRS_ONE;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        ahrs->q[i + 1] = 0;
+        ahrs->integral[i] = 0;
+    }
+
+    // Use as many bits for the gyroscope factor as fit into 15 bits
+    ahrs->gyro_shift = 0;
+    while ((numerator << 1) / sample_rate < 32768 && numerator < (1UL << 30))
+    {
+        numerator <<= 1;
+        ahrs->gyro_shift++;
+    }
+    ahrs->gyro_factor = (numerator + sample_rate / 2) / sample_rate;
+
+    // Kp * dt / 2 in Q19 and Ki * dt^2 / 2 in Q33
+    ahrs->kp = ahrs_saturate((((uint32_t)kp << 10) + sample_rate / 2) / sample_rate);
+    ahrs->ki = ahrs_saturate((((uint32_t)ki << 24) + rate_squared / 2) / rate_squared);
+}
+
+void ahrs_update(struct ahrs *ahrs, const int16_t gyro[3], const int16_t accel[3], const int16_t mag[3])
+{
+    int16_t q[4];
+    int16_t matrix[3][3];
+    int16_t a[3] = {accel[0], accel[1], accel[2]};
+    int32_t error[3] = {0, 0, 0};
+    int32_t rotation[3];
+    int32_t change[4];
+    uint32_t norm = 0;
+
+    ahrs_quaternion_q15(ahrs, q);
+    ahrs_rotation_matrix(q, matrix);
+
+    if (ahrs_normalize(a))
+    {
+        // The estimated direction of gravity is the last row of the matrix, the error is the cross product with the measurement
+        error[0] = ((int32_t)a[1] * matrix[2][2] - (int32_t)a[2] * matrix[2][1]) >> 14;
+        error[1] = ((int32_t)a[2] * matrix[2][0] - (int32_t)a[0] * matrix[2][2]) >> 14;
+        error[2] = ((int32_t)a[0] * matrix[2][1] - (int32_t)a[1] * matrix[2][0]) >> 14;
+
+        int16_t m[3];
+        if (mag)
+        {
+            // AK09916 to accelerometer frame
+            m[0] = mag[0];
+            m[1] = -mag[1];
+            m[2] = -mag[2];
+        }
+        if (mag && ahrs_normalize(m))
+        {
+            int16_t h[3];
+            int16_t w[3];
+
+            // Magnetic field in the earth frame
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                h[i] = ahrs_saturate(((int32_t)matrix[i][0] * m[0] + (int32_t)matrix[i][1] * m[1] + (int32_t)matrix[i][2] * m[2]) >> 14);
+            }
+
+            // Reference field only points north and down, rotate it back into the sensor frame
+            int16_t bx = ahrs_saturate(ahrs_sqrt((uint32_t)((int32_t)h[0] * h[0]) + (uint32_t)((int32_t)h[1] * h[1])));
+            int16_t bz = h[2];
+            for (uint8_t i = 0; i < 3; i++)
+            {
+                w[i] = ahrs_saturate(((int32_t)matrix[0][i] * bx + (int32_t)matrix[2][i] * bz) >> 14);
+            }
+
+            error[0] += ((int32_t)m[1] * w[2] - (int32_t)m[2] * w[1]) >> 15;
+            error[1] += ((int32_t)m[2] * w[0] - (int32_t)m[0] * w[2]) >> 15;
+            error[2] += ((int32_t)m[0] * w[1] - (int32_t)m[1] * w[0]) >> 15;
+        }
+    }
+
+    // Rotation in this sample period (half angle, Q30) including proportional and integral feedback
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        int16_t e = ahrs_saturate(error[i]);
+
+        ahrs->integral[i] += ((int32_t)e * ahrs->ki) >> 10;
+        rotation[i] = (((int32_t)gyro[i] * ahrs->gyro_factor) >> ahrs->gyro_shift) + (ahrs->integral[i] >> 8) + (((int32_t)e * ahrs->kp) >> 4);
+    }
+
+    // q = q + q * (0, rotation)
+    change[0] = -ahrs_multiply(rotation[0], q[1], 15) - ahrs_multiply(rotation[1], q[2], 15) - ahrs_multiply(rotation[2], q[3], 15);
+    change[1] = ahrs_multiply(rotation[0], q[0], 15) + ahrs_multiply(rotation[2], q[2], 15) - ahrs_multiply(rotation[1], q[3], 15);
+    change[2] = ahrs_multiply(rotation[1], q[0], 15) - ahrs_multiply(rotation[2], q[1], 15) + ahrs_multiply(rotation[0], q[3], 15);
+    change[3] = ahrs_multiply(rotation[2], q[0], 15) + ahrs_multiply(rotation[1], q[1], 15) - ahrs_multiply(rotation[0], q[2], 15);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        ahrs->q[i] += change[i];
+    }
+
+    // Renormalise with one Newton step of 1 / sqrt(norm), the quaternion is always close to length 1
+    ahrs_quaternion_q15(ahrs, q);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        norm += (int32_t)q[i] * q[i];
+    }
+    int16_t factor = (int16_t)(((3UL << 30) - norm) >> 17);    // (3 - norm) / 2 in Q14
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        ahrs->q[i] = ahrs_multiply(ahrs->q[i], factor, 14);
+    }
+}
+
+void ahrs_get_euler(const struct ahrs *ahrs, int16_t *roll, int16_t *pitch, int16_t *yaw)
+{
+    int16_t q[4];
+    int16_t matrix[3][3];
+    uint32_t horizontal;
+
+    ahrs_quaternion_q15(ahrs, q);
+    ahrs_rotation_matrix(q, matrix);
+
+    // The length of (r21, r22) is cos(pitch), so no asin is needed
+    *roll = cordic_atan2(matrix[2][1], matrix[2][2], &horizontal);
+    *pitch = cordic_atan2(-matrix[2][0], horizontal, NULL);
+    *yaw = cordic_atan2(matrix[1][0], matrix[0][0], NULL);
+}
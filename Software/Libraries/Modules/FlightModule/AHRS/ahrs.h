@@ -0,0 +1,73 @@
+/*
+ * ahrs.h
+ *
+ * Fixed-point Mahony filter which calculates the orientation of the flight module
+ * from the gyroscope, accelerometer and magnetometer of the ICM20948.
+ *
+ * Created: 19.10.2026 09:40:12
+ */
+
+
+#ifndef AHRS_H_
+#define AHRS_H_
+
+#include <stdint.h>
+
+/**
+ * @def AHRS_ONE
+ *
+ * The value 1.0 of the quaternion components (Q30).
+ */
+#define AHRS_ONE (1L << 30)
+
+/**
+ * @brief State of the filter.
+ *
+ * All values are fixed-point, no float operations are used.
+ * The gains and the gyroscope scaling already include the sample period, so `ahrs_update` only needs multiplications and shifts.
+ */
+struct ahrs
+{
+    int32_t q[4];           /**< Orientation quaternion w, x, y, z (Q30), rotates from the sensor to the earth frame */
+    int32_t integral[3];    /**< Integral feedback in rad per half sample period (Q38), the small increments would get lost in Q30 */
+    int16_t gyro_factor;    /**< Raw gyroscope value to rad per half sample period: (raw * gyro_factor) >> gyro_shift (Q30) */
+    uint8_t gyro_shift;     /**< See gyro_factor */
+    int16_t kp;             /**< Kp * dt / 2 (Q19) */
+    int16_t ki;             /**< Ki * dt^2 / 2 (Q33) */
+};
+
+/**
+ * @brief Initialise the filter.
+ * The orientation is reset to the identity quaternion.
+ *
+ * @param[out] ahrs The filter to initialise.
+ * @param[in] gyro_range Full scale range of the gyroscope (ICM20948_GYRO_RANGE_250DPS - ICM20948_GYRO_RANGE_2000DPS).
+ * @param[in] sample_rate Rate at which `ahrs_update` is called in Hz.
+ * @param[in] kp Proportional gain in Q8 (256 = 1.0). Typical values are 256 - 512.
+ * @param[in] ki Integral gain in Q8 (0 - 255). Typical values are 0 - 26.
+ */
+void ahrs_init(struct ahrs *ahrs, uint8_t gyro_range, uint16_t sample_rate, uint16_t kp, uint8_t ki);
+
+/**
+ * @brief Update the orientation with a new sample.
+ * The arrays can be taken from `struct icm20948_sample` directly.
+ * The magnetometer axes are converted from the AK09916 frame (y and z inverted) to the frame of the accelerometer.
+ *
+ * @param[in,out] ahrs The filter.
+ * @param[in] gyro Raw gyroscope values of the x-, y- and z-axis.
+ * @param[in] accel Raw accelerometer values of the x-, y- and z-axis. The range does not matter.
+ * @param[in] mag Raw magnetometer values of the AK09916 or NULL to only use the gyroscope and accelerometer (no heading correction).
+ */
+void ahrs_update(struct ahrs *ahrs, const int16_t gyro[3], const int16_t accel[3], const int16_t mag[3]);
+
+/**
+ * @brief Get the orientation as Euler angles (yaw, pitch, roll rotation order).
+ *
+ * @param[in] ahrs The filter.
+ * @param[out] roll Rotation around the x-axis in centi-degrees (-18000 to 18000).
+ * @param[out] pitch Rotation around the y-axis in centi-degrees (-9000 to 9000).
+ * @param[out] yaw Rotation around the z-axis in centi-degrees (-18000 to 18000).
+ */
+void ahrs_get_euler(const struct ahrs *ahrs, int16_t *roll, int16_t *pitch, int16_t *yaw);
+
+#endif /* AHRS_H_ */
@@ -0,0 +1,149 @@
+/*
+ * cordic.c
+ *
+ * Created: 19.10.2026 09:12:31
+ */
+
+#include "cordic.h"
+#include <stddef.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_dword(address) (*(address))
+#endif
+
+/**
+ * @def CORDIC_HALF_TURN
+ *
+ * 180 degrees in the unit of cordic_atan_table.
+ */
+#define CORDIC_HALF_TURN (18000L * 256)
+
+/**
+ * @def CORDIC_INVERSE_GAIN
+ *
+ * 1 / 1.64676 (the gain of 16 CORDIC iterations) in Q16.
+ */
+#define CORDIC_INVERSE_GAIN 39797UL
+
+// atan(2^-i) in 1/256 centi-degrees
+static const int32_t cordic_atan_table[CORDIC_ITERATIONS] PROGMEM =
+{
+    1152000, 680065, 359328, 182400, 91554, 45822, 22916, 11459,
+    5730, 2865, 1432, 716, 358, 179, 90, 45
+};
+
+/**
+ * @brief Remove the CORDIC gain from a value.
+ *
+ * @param[in] value The value multiplied by the gain.
+ * @return value / 1.64676
+ */
+static int32_t cordic_remove_gain(int32_t value)
+{
+    uint32_t magnitude = (value < 0) ? -value : value;
+
+    magnitude = ((magnitude >> 16) * CORDIC_INVERSE_GAIN) + (((magnitude & 0xFFFF) * CORDIC_INVERSE_GAIN) >> 16);
+    return (value < 0) ? -(int32_t)magnitude : (int32_t)magnitude;
+}
+
+int16_t cordic_atan2_rotate(int32_t y, int32_t x, uint32_t *magnitude, int32_t *rotate_y, int32_t *rotate_x)
+{
+    int32_t angle = 0;
+    int8_t scale = 0;
+    uint32_t largest;
+    int32_t second_x = rotate_x ? *rotate_x : 0;
+    int32_t second_y = rotate_y ? *rotate_y : 0;
+
+    if (x == 0 && y == 0)
+    {
+        if (magnitude)
+        {
+            *magnitude = 0;
+        }
+        return 0;
+    }
+
+    // The iterations only converge for -99 to 99 degrees, so rotate the left half plane by 180 degrees
+    if (x < 0)
+    {
+        angle = (y >= 0) ? CORDIC_HALF_TURN : -CORDIC_HALF_TURN;
+        x = -x;
+        y = -y;
+        second_x = -second_x;
+        second_y = -second_y;
+    }
+
+    // Scale the larger component to 2^28 - 2^29: enough precision, and the gain of 1.65 cannot overflow
+    largest = (y < 0) ? -y : y;
+    if ((uint32_t)x > largest)
+    {
+        largest = x;
+    }
+    while (largest >= (1UL << 29))
+    {
+        x >>= 1;
+        y >>= 1;
+        largest >>= 1;
+        scale++;
+    }
+    while (largest < (1UL << 28))
+    {
+        x <<= 1;
+        y <<= 1;
+        largest <<= 1;
+        scale--;
+    }
+
+    // Rotate the vector onto the x-axis and sum up the angles used
+    for (uint8_t i = 0; i < CORDIC_ITERATIONS; i++)
+    {
+        int32_t step = pgm_read_dword(&cordic_atan_table[i]);
+        int32_t next_x;
+        int32_t next_second_x;
+
+        if (y > 0)
+        {
+            next_x = x + (y >> i);
+            y -= x >> i;
+            next_second_x = second_x + (second_y >> i);
+            second_y -= second_x >> i;
+            angle += step;
+        }
+        else
+        {
+            next_x = x - (y >> i);
+            y += x >> i;
+            next_second_x = second_x - (second_y >> i);
+            second_y += second_x >> i;
+            angle -= step;
+        }
+        x = next_x;
+        second_x = next_second_x;
+    }
+
+    if (magnitude)
+    {
+        // x is now the length multiplied by the CORDIC gain
+        uint32_t length = cordic_remove_gain(x);
+
+        *magnitude = (scale >= 0) ? (length << scale) : (length >> -scale);
+    }
+    if (rotate_x)
+    {
+        *rotate_x = cordic_remove_gain(second_x);
+    }
+    if (rotate_y)
+    {
+        *rotate_y = cordic_remove_gain(second_y);
+    }
+
+    return (int16_t)((angle + 128) >> 8);
+}
+
+int16_t cordic_atan2(int32_t y, int32_t x, uint32_t *magnitude)
+{
+    return cordic_atan2_rotate(y, x, magnitude, NULL, NULL);
+}
@@ -0,0 +1,50 @@
+/*
+ * cordic.h
+ *
+ * Created: 19.10.2026 09:12:40
+ */
+
+
+#ifndef CORDIC_H_
+#define CORDIC_H_
+
+#include <stdint.h>
+
+/**
+ * @def CORDIC_ITERATIONS
+ *
+ * Number of CORDIC iterations. Every iteration adds about one bit of precision to the angle.
+ * With 16 iterations the remaining angle is below atan(2^-15) = 0.0018 degrees.
+ */
+#define CORDIC_ITERATIONS 16
+
+/**
+ * @brief Calculate the angle and the length of the vector (x, y) using integer CORDIC.
+ * This replaces `atan2` and `sqrt` of the float library, so no float code has to be linked.
+ * Only additions and shifts are used, no multiplications or divisions. The speed on the ATmega16A has not been measured.
+ *
+ * The angle is rounded to centi-degrees and is off by at most 1 centi-degree
+ * (0.18 from the iterations, 0.03 from the table, 0.5 from rounding).
+ *
+ * @param[in] y The y-component of the vector, |y| <= 2^30.
+ * @param[in] x The x-component of the vector, |x| <= 2^30.
+ * @param[out] magnitude If not NULL, the length of the vector sqrt(x^2 + y^2) is stored here (relative error below 2^-15).
+ * @return The angle of the vector in centi-degrees (-18000 to 18000), 0 for a vector of length 0.
+ */
+int16_t cordic_atan2(int32_t y, int32_t x, uint32_t *magnitude);
+
+/**
+ * @brief Calculate the angle of the vector (x, y) and rotate a second vector by the negative angle.
+ * The second vector goes through the same CORDIC steps as the first one, so no sin or cos is needed.
+ * This is used to rotate one sensor vector into the frame defined by another one, e.g. the magnetic field into the horizontal plane.
+ *
+ * @param[in] y The y-component of the vector, |y| <= 2^30.
+ * @param[in] x The x-component of the vector, |x| <= 2^30.
+ * @param[out] magnitude If not NULL, the length of the vector sqrt(x^2 + y^2) is stored here.
+ * @param[in,out] rotate_y The y-component of the second vector, |rotate_y| <= 2^28.
+ * @param[in,out] rotate_x The x-component of the second vector, |rotate_x| <= 2^28.
+ * @return The angle of the vector in centi-degrees (-18000 to 18000), 0 for a vector of length 0.
+ */
+int16_t cordic_atan2_rotate(int32_t y, int32_t x, uint32_t *magnitude, int32_t *rotate_y, int32_t *rotate_x);
+
+#endif /* CORDIC_H_ */
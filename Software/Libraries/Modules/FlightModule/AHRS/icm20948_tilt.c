@@ -0,0 +1,52 @@
+/*
+ * icm20948_tilt.c
+ *
+ * Created: 19.10.2026 11:34:38
+ */
+
+#include "icm20948_tilt.h"
+#include "cordic.h"
+#include <stddef.h>
+
+void icm20948_tilt(const struct icm20948_sample *sample, int16_t *pitch, int16_t *roll, uint16_t *heading)
+{
+    // AK09916 to accelerometer frame
+    int32_t mx = sample->mag[0];
+    int32_t my = -(int32_t)sample->mag[1];
+    int32_t mz = -(int32_t)sample->mag[2];
+    uint32_t largest = 0;
+    uint32_t horizontal;
+    int16_t angle;
+
+    // The magnetic field is only rotated, not scaled by CORDIC: give it 2^26 - 2^27 for precision
+    int32_t components[3] = {mx, my, mz};
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        uint32_t value = (components[i] < 0) ? -components[i] : components[i];
+        if (value > largest)
+        {
+            largest = value;
+        }
+    }
+    if (largest)
+    {
+        while (largest < (1UL << 26))
+        {
+            largest <<= 1;
+            mx <<= 1;
+            my <<= 1;
+            mz <<= 1;
+        }
+    }
+
+    // Roll: rotate gravity (az, ay) onto the z-axis, the magnetic field (mz, my) follows.
+    // The shift keeps the fraction bits of the length, which is used for the pitch.
+    *roll = cordic_atan2_rotate((int32_t)sample->accel[1] << 14, (int32_t)sample->accel[2] << 14, &horizontal, &my, &mz);
+
+    // Pitch: rotate gravity (horizontal, -ax) onto the z-axis, the magnetic field (mx, mz) follows
+    *pitch = cordic_atan2_rotate(-((int32_t)sample->accel[0] << 14), horizontal, NULL, &mz, &mx);
+
+    // mx and my are now the horizontal components of the magnetic field
+    angle = cordic_atan2(-my, mx, NULL);
+    *heading = (angle < 0) ? (uint16_t)(angle + 36000L) : (uint16_t)angle;
+}
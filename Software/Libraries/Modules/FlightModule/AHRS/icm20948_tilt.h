@@ -0,0 +1,32 @@
+/*
+ * icm20948_tilt.h
+ *
+ * Tilt-compensated heading, pitch and roll from the accelerometer and magnetometer of the ICM20948
+ * using integer CORDIC instead of atan2 and sqrt of the float library. This keeps the float library
+ * out of flash and needs no float operations; it is not claimed to be faster on the ATmega16A.
+ *
+ * Created: 19.10.2026 11:34:47
+ */
+
+
+#ifndef ICM20948_TILT_H_
+#define ICM20948_TILT_H_
+
+#include "icm20948_sample.h"
+
+/**
+ * @brief Calculate pitch, roll and tilt-compensated heading of a sample.
+ * Only the accelerometer and magnetometer values are used, so the result is only valid while the module is not accelerated.
+ * The sample has to be read with `icm20948_read_sample_9axis`.
+ *
+ * Compared to the same calculation with double precision atan2 and sqrt the results are off by at most
+ * 1 centi-degree for pitch and roll and 2 centi-degrees for the heading (see test_tilt.c).
+ *
+ * @param[in] sample The sample.
+ * @param[out] pitch Rotation around the y-axis in centi-degrees (-9000 to 9000).
+ * @param[out] roll Rotation around the x-axis in centi-degrees (-18000 to 18000).
+ * @param[out] heading Angle between the x-axis and magnetic north in centi-degrees (0 to 35999), unsigned as 35999 exceeds int16_t.
+ */
+void icm20948_tilt(const struct icm20948_sample *sample, int16_t *pitch, int16_t *roll, uint16_t *heading);
+
+#endif /* ICM20948_TILT_H_ */
@@ -0,0 +1,316 @@
+/*
+ * test_host.c
+ *
+ * Host harness for the fixed-point AHRS. Replays IMU data through `ahrs_update`
+ * and a double-precision version of the same Mahony filter and reports the angle
+ * error of the fixed-point filter. This is an accuracy check only: the host has
+ * nothing in common with the ATmega16A, so no timing is measured here.
+ *
+ * Build and run on Linux:
+ *     gcc -O2 -o test_host test_host.c ahrs.c cordic.c -lm
+ *     ./test_host                                   (synthetic flight)
+ *     ./test_host recording.csv 200 3               (recording, sample rate in Hz, gyro range)
+ *
+ * A recording has one sample per line with the raw values of `icm20948_read_sample_9axis`:
+ *     gx,gy,gz,ax,ay,az,mx,my,mz
+ *
+ * Created: 19.10.2026 10:31:55
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ahrs.h"
+
+#define KP 512              // 2.0 in Q8
+#define KI 13               // 0.05 in Q8
+#define MAX_SAMPLES 100000
+
+struct record
+{
+    int16_t gyro[3];
+    int16_t accel[3];
+    int16_t mag[3];
+    double truth[4];        // True quaternion of synthetic data, w = 0 if unknown
+};
+
+static struct record records[MAX_SAMPLES];
+
+// Double-precision Mahony filter with the same gains and conventions as ahrs.c
+struct reference
+{
+    double q[4];
+    double integral[3];
+    double gyro_scale;      // rad/s per LSB
+    double dt;
+    double kp;
+    double ki;
+};
+
+static void normalize(double *v, int n)
+{
+    double length = 0;
+    for (int i = 0; i < n; i++)
+    {
+        length += v[i] * v[i];
+    }
+    length = sqrt(length);
+    if (length > 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            v[i] /= length;
+        }
+    }
+}
+
+static void reference_update(struct reference *r, const struct record *s)
+{
+    double *q = r->q;
+    double a[3] = {s->accel[0], s->accel[1], s->accel[2]};
+    double m[3] = {s->mag[0], -s->mag[1], -s->mag[2]};
+    double e[3];
+    double g[3];
+
+    normalize(a, 3);
+    normalize(m, 3);
+
+    double v[3] = {2 * (q[1]*q[3] - q[0]*q[2]), 2 * (q[0]*q[1] + q[2]*q[3]), 1 - 2 * (q[1]*q[1] + q[2]*q[2])};
+    double R[3][3] =
+    {
+        {1 - 2 * (q[2]*q[2] + q[3]*q[3]), 2 * (q[1]*q[2] - q[0]*q[3]), 2 * (q[1]*q[3] + q[0]*q[2])},
+        {2 * (q[1]*q[2] + q[0]*q[3]), 1 - 2 * (q[1]*q[1] + q[3]*q[3]), 2 * (q[2]*q[3] - q[0]*q[1])},
+        {2 * (q[1]*q[3] - q[0]*q[2]), 2 * (q[2]*q[3] + q[0]*q[1]), 1 - 2 * (q[1]*q[1] + q[2]*q[2])},
+    };
+    double h[3];
+    for (int i = 0; i < 3; i++)
+    {
+        h[i] = R[i][0] * m[0] + R[i][1] * m[1] + R[i][2] * m[2];
+    }
+    double bx = sqrt(h[0] * h[0] + h[1] * h[1]);
+    double bz = h[2];
+    double w[3];
+    for (int i = 0; i < 3; i++)
+    {
+        w[i] = R[0][i] * bx + R[2][i] * bz;
+    }
+
+    e[0] = (a[1] * v[2] - a[2] * v[1]) + (m[1] * w[2] - m[2] * w[1]);
+    e[1] = (a[2] * v[0] - a[0] * v[2]) + (m[2] * w[0] - m[0] * w[2]);
+    e[2] = (a[0] * v[1] - a[1] * v[0]) + (m[0] * w[1] - m[1] * w[0]);
+
+    for (int i = 0; i < 3; i++)
+    {
+        r->integral[i] += r->ki * e[i] * r->dt;
+        g[i] = s->gyro[i] * r->gyro_scale + r->kp * e[i] + r->integral[i];
+        g[i] *= 0.5 * r->dt;
+    }
+
+    double dq[4] =
+    {
+        -q[1] * g[0] - q[2] * g[1] - q[3] * g[2],
+        q[0] * g[0] + q[2] * g[2] - q[3] * g[1],
+        q[0] * g[1] - q[1] * g[2] + q[3] * g[0],
+        q[0] * g[2] + q[1] * g[1] - q[2] * g[0],
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        q[i] += dq[i];
+    }
+    normalize(q, 4);
+}
+
+// Rotation angle of conj(a) * b in degrees, atan2 stays precise for small angles where acos does not
+static double quaternion_angle(const double a[4], const double b[4])
+{
+    double w = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+    double x = a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+    double y = a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+    double z = a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+    return 2 * atan2(sqrt(x * x + y * y + z * z), fabs(w)) * 180 / M_PI;
+}
+
+static double gaussian(void)
+{
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static int16_t to_raw(double value)
+{
+    value = round(value);
+    return value > 32767 ? 32767 : (value < -32768 ? -32768 : (int16_t)value);
+}
+
+// Synthetic flight: smooth rotations around all axes, gravity and a magnetic field with 64 degrees inclination
+static int generate(int count, int rate, int gyro_range)
+{
+    double q[4] = {1, 0, 0, 0};
+    double lsb_per_dps = 32768.0 / (250 << gyro_range);
+    double field[3] = {cos(64 * M_PI / 180), 0, -sin(64 * M_PI / 180)};
+
+    srand(1);
+    for (int n = 0; n < count; n++)
+    {
+        double t = (double)n / rate;
+        double omega[3] =
+        {
+            90 * sin(2 * M_PI * 0.21 * t),
+            60 * sin(2 * M_PI * 0.13 * t + 1),
+            45 * sin(2 * M_PI * 0.07 * t + 2),
+        };
+        struct record *s = &records[n];
+        double R[3][3] =
+        {
+            {1 - 2 * (q[2]*q[2] + q[3]*q[3]), 2 * (q[1]*q[2] - q[0]*q[3]), 2 * (q[1]*q[3] + q[0]*q[2])},
+            {2 * (q[1]*q[2] + q[0]*q[3]), 1 - 2 * (q[1]*q[1] + q[3]*q[3]), 2 * (q[2]*q[3] - q[0]*q[1])},
+            {2 * (q[1]*q[3] - q[0]*q[2]), 2 * (q[2]*q[3] + q[0]*q[1]), 1 - 2 * (q[1]*q[1] + q[2]*q[2])},
+        };
+
+        memcpy(s->truth, q, sizeof(q));
+        for (int i = 0; i < 3; i++)
+        {
+            // Sensor frame = transposed rotation of the earth frame vectors, 1 g = 16384 LSB, 50 uT = 333 LSB
+            double mag = 333 * (R[0][i] * field[0] + R[1][i] * field[1] + R[2][i] * field[2]);
+            s->gyro[i] = to_raw(omega[i] * lsb_per_dps + 0.1 * lsb_per_dps * gaussian());
+            s->accel[i] = to_raw(16384 * R[2][i] + 40 * gaussian());
+            s->mag[i] = to_raw((i == 0 ? 1 : -1) * mag + 2 * gaussian());
+        }
+
+        // Propagate the true orientation in small steps
+        for (int step = 0; step < 10; step++)
+        {
+            double h[3];
+            for (int i = 0; i < 3; i++)
+            {
+                h[i] = omega[i] * M_PI / 180 * 0.5 / (10.0 * rate);
+            }
+            double dq[4] =
+            {
+                -q[1] * h[0] - q[2] * h[1] - q[3] * h[2],
+                q[0] * h[0] + q[2] * h[2] - q[3] * h[1],
+                q[0] * h[1] - q[1] * h[2] + q[3] * h[0],
+                q[0] * h[2] + q[1] * h[1] - q[2] * h[0],
+            };
+            for (int i = 0; i < 4; i++)
+            {
+                q[i] += dq[i];
+            }
+            normalize(q, 4);
+        }
+    }
+    return count;
+}
+
+static int load(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    int count = 0;
+
+    if (!file)
+    {
+        perror(path);
+        exit(1);
+    }
+    while (count < MAX_SAMPLES && fgets(line, sizeof(line), file))
+    {
+        int v[9];
+        if (sscanf(line, "%d,%d,%d,%d,%d,%d,%d,%d,%d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]) != 9)
+        {
+            continue;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            records[count].gyro[i] = v[i];
+            records[count].accel[i] = v[3 + i];
+            records[count].mag[i] = v[6 + i];
+        }
+        records[count].truth[0] = 0;
+        count++;
+    }
+    fclose(file);
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    int rate = argc > 2 ? atoi(argv[2]) : 200;
+    int gyro_range = argc > 3 ? atoi(argv[3]) : 3;
+    int count = argc > 1 ? load(argv[1]) : generate(60 * rate, rate, gyro_range);
+    struct ahrs ahrs;
+    struct reference reference = {{1, 0, 0, 0}, {0, 0, 0}, (250 << gyro_range) / 32768.0 * M_PI / 180, 1.0 / rate, KP / 256.0, KI / 256.0};
+    double error_max = 0, error_sum = 0, truth_max = 0, truth_reference_max = 0;
+    double euler_max[3] = {0, 0, 0};
+    int compared = 0;
+
+    if (count == 0)
+    {
+        fprintf(stderr, "no samples\n");
+        return 1;
+    }
+
+    // Accuracy: both filters side by side, the first 5 seconds are convergence
+    ahrs_init(&ahrs, gyro_range, rate, KP, KI);
+    for (int n = 0; n < count; n++)
+    {
+        double q[4];
+        int16_t roll, pitch, yaw;
+
+        ahrs_update(&ahrs, records[n].gyro, records[n].accel, records[n].mag);
+        reference_update(&reference, &records[n]);
+        if (n < 5 * rate)
+        {
+            continue;
+        }
+
+        for (int i = 0; i < 4; i++)
+        {
+            q[i] = (double)ahrs.q[i] / AHRS_ONE;
+        }
+        normalize(q, 4);
+        double error = quaternion_angle(q, reference.q);
+        error_max = fmax(error_max, error);
+        error_sum += error * error;
+        compared++;
+
+        // Euler angles against the reference (skipping gimbal lock, where roll and yaw are undefined)
+        double *r = reference.q;
+        double ref_pitch = asin(fmax(-1, fmin(1, -2 * (r[1]*r[3] - r[0]*r[2])))) * 180 / M_PI;
+        if (fabs(ref_pitch) < 80)
+        {
+            double ref[3] =
+            {
+                atan2(2 * (r[2]*r[3] + r[0]*r[1]), 1 - 2 * (r[1]*r[1] + r[2]*r[2])) * 180 / M_PI,
+                ref_pitch,
+                atan2(2 * (r[1]*r[2] + r[0]*r[3]), 1 - 2 * (r[2]*r[2] + r[3]*r[3])) * 180 / M_PI,
+            };
+            ahrs_get_euler(&ahrs, &roll, &pitch, &yaw);
+            double fixed[3] = {roll / 100.0, pitch / 100.0, yaw / 100.0};
+            for (int i = 0; i < 3; i++)
+            {
+                double difference = fabs(fixed[i] - ref[i]);
+                euler_max[i] = fmax(euler_max[i], fmin(difference, 360 - difference));
+            }
+        }
+
+        if (records[n].truth[0] != 0)
+        {
+            truth_max = fmax(truth_max, quaternion_angle(q, records[n].truth));
+            truth_reference_max = fmax(truth_reference_max, quaternion_angle(reference.q, records[n].truth));
+        }
+    }
+
+    printf("samples:                 %d at %d Hz\n", count, rate);
+    printf("error vs double filter:  max %.4f deg, rms %.4f deg\n", error_max, sqrt(error_sum / compared));
+    printf("euler error vs double:   roll %.3f, pitch %.3f, yaw %.3f deg (max)\n", euler_max[0], euler_max[1], euler_max[2]);
+    if (truth_max > 0)
+    {
+        printf("error vs ground truth:   fixed %.3f deg, double %.3f deg (max)\n", truth_max, truth_reference_max);
+    }
+
+    return error_max < 1.0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/*
+ * test_tilt.c
+ *
+ * Host accuracy test for `icm20948_tilt`. Compares the integer CORDIC version against the
+ * same calculation with atan2 and sqrt of the math library and checks the error of pitch,
+ * roll and heading against the bounds documented in icm20948_tilt.h.
+ *
+ * Build and run on Linux:
+ *     gcc -O2 -I../ICM_20948 -o test_tilt test_tilt.c icm20948_tilt.c cordic.c -lm
+ *     ./test_tilt
+ *
+ * No timing is measured: the host has an FPU and nothing in common with the ATmega16A.
+ *
+ * Created: 19.10.2026 11:52:16
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "icm20948_tilt.h"
+
+#define SAMPLES 100000
+#define GRAVITY 8192        // 1 g at +-4 g full scale
+#define FIELD 330           // 50 uT at 0.15 uT/LSB
+#define INCLINATION 64      // Degrees, central Europe
+
+static struct icm20948_sample samples[SAMPLES];
+
+// Same calculation as icm20948_tilt with the float library
+static void reference_tilt(const struct icm20948_sample *sample, double *pitch, double *roll, double *heading)
+{
+    double ax = sample->accel[0], ay = sample->accel[1], az = sample->accel[2];
+    double mx = sample->mag[0], my = -sample->mag[1], mz = -sample->mag[2];
+
+    double phi = atan2(ay, az);
+    double theta = atan2(-ax, sqrt(ay * ay + az * az));
+    double yh = my * cos(phi) - mz * sin(phi);
+    double zr = mz * cos(phi) + my * sin(phi);
+    double xh = mx * cos(theta) + zr * sin(theta);
+    double psi = atan2(-yh, xh);
+
+    *roll = phi * 18000 / M_PI;
+    *pitch = theta * 18000 / M_PI;
+    *heading = psi < 0 ? (psi + 2 * M_PI) * 18000 / M_PI : psi * 18000 / M_PI;
+}
+
+static double uniform(double low, double high)
+{
+    return low + (high - low) * rand() / (double)RAND_MAX;
+}
+
+static int16_t noisy(double value)
+{
+    return (int16_t)lrint(value + uniform(-3, 3));
+}
+
+// Random orientations with gravity and earth field rotated into the sensor frame
+static void generate(void)
+{
+    double inclination = INCLINATION * M_PI / 180;
+    double field[3] = {FIELD * cos(inclination), 0, -FIELD * sin(inclination)};
+
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        double phi = uniform(-M_PI, M_PI);
+        double theta = uniform(-M_PI / 2 * 0.99, M_PI / 2 * 0.99);
+        double psi = uniform(-M_PI, M_PI);
+        double cp = cos(phi), sp = sin(phi), ct = cos(theta), st = sin(theta), cy = cos(psi), sy = sin(psi);
+
+        // Rows of R^T with R = Rz(psi) Ry(theta) Rx(phi)
+        double r[3][3] =
+        {
+            {ct * cy, ct * sy, -st},
+            {sp * st * cy - cp * sy, sp * st * sy + cp * cy, sp * ct},
+            {cp * st * cy + sp * sy, cp * st * sy - sp * cy, cp * ct}
+        };
+        for (int i = 0; i < 3; i++)
+        {
+            double b = r[i][0] * field[0] + r[i][1] * field[1] + r[i][2] * field[2];
+
+            samples[n].accel[i] = noisy(GRAVITY * r[i][2]);
+            // AK09916 axes: x same, y and z inverted
+            samples[n].mag[i] = noisy(i == 0 ? b : -b);
+        }
+    }
+}
+
+static double angle_difference(double a, double b)
+{
+    double difference = fmod(fabs(a - b), 36000);
+    return difference > 18000 ? 36000 - difference : difference;
+}
+
+int main(void)
+{
+    double error_max[3] = {0, 0, 0};
+
+    generate();
+
+    for (int n = 0; n < SAMPLES; n++)
+    {
+        int16_t pitch, roll;
+        uint16_t heading;
+        double ref_pitch, ref_roll, ref_heading;
+
+        icm20948_tilt(&samples[n], &pitch, &roll, &heading);
+        reference_tilt(&samples[n], &ref_pitch, &ref_roll, &ref_heading);
+
+        error_max[0] = fmax(error_max[0], fabs(pitch - ref_pitch));
+        error_max[1] = fmax(error_max[1], angle_difference(roll, ref_roll));
+        error_max[2] = fmax(error_max[2], angle_difference(heading, ref_heading));
+        if (heading >= 36000 || pitch < -9000 || pitch > 9000)
+        {
+            printf("out of range at sample %d\n", n);
+            return 1;
+        }
+    }
+
+    printf("samples:                  %d\n", SAMPLES);
+    printf("max error vs double:      pitch %.2f, roll %.2f, heading %.2f centi-degrees\n", error_max[0], error_max[1], error_max[2]);
+
+    // Documented bound in icm20948_tilt.h
+    return (error_max[0] <= 1 && error_max[1] <= 1 && error_max[2] <= 2) ? 0 : 1;
+}
@@ -12,150 +12,566 @@
  */
 
 #include "icm20948.h"
+#include <util/delay.h>
+#include <avr/pgmspace.h>
+#include <avr/eeprom.h>
 
-uint16_t icm20948_get_accelerometer_x_raw()
+#ifdef ICM20948_INTERRUPT
+#include <avr/interrupt.h>
+
+#if ICM20948_INTERRUPT == 0
+#define ICM20948_INTERRUPT_VECTOR INT0_vect
+#define ICM20948_INTERRUPT_ENABLE (1 << INT0)
+#elif ICM20948_INTERRUPT == 1
+#define ICM20948_INTERRUPT_VECTOR INT1_vect
+#define ICM20948_INTERRUPT_ENABLE (1 << INT1)
+#elif ICM20948_INTERRUPT == 2
+#define ICM20948_INTERRUPT_VECTOR INT2_vect
+#define ICM20948_INTERRUPT_ENABLE (1 << INT2)
+#else
+#error "ICM20948_INTERRUPT has to be 0, 1 or 2"
+#endif
+
+// Set by the ISR when the INT pin became active
+static volatile uint8_t icm20948_interrupt_flag = 0;
+
+ISR(ICM20948_INTERRUPT_VECTOR)
 {
-    uint16_t data = 0;
+    // The pin stays active until ICM20948_REG_INT_STATUS is read over I2C, so the level interrupt is stopped until then
+    GICR &= ~ICM20948_INTERRUPT_ENABLE;
+    icm20948_interrupt_flag = 1;
+}
 
+/**
+ * @brief Configure and enable the external interrupt for the INT pin (active low).
+ */
+static void icm20948_interrupt_enable()
+{
+#if ICM20948_INTERRUPT == 0
+    DDRD &= ~(1 << PD2);
+    MCUCR &= ~((1 << ISC01) | (1 << ISC00));    // Low level
+#elif ICM20948_INTERRUPT == 1
+    DDRD &= ~(1 << PD3);
+    MCUCR &= ~((1 << ISC11) | (1 << ISC10));    // Low level
+#else
+    DDRB &= ~(1 << PB2);
+    MCUCSR &= ~(1 << ISC2);                     // Falling edge, INT2 has no level mode
+    GIFR = (1 << INTF2);
+#endif
+    GICR |= ICM20948_INTERRUPT_ENABLE;
+}
+#endif
+
+// Estimated group delay in us of the gyroscope low pass filter for ICM20948_DLPF_0 - ICM20948_DLPF_7 and ICM20948_DLPF_OFF
+static const uint16_t icm20948_gyro_group_delay[9] PROGMEM = {810, 1048, 1332, 3108, 6659, 13720, 27922, 440, 13};
+
+// Estimated group delay in us of the accelerometer low pass filter for ICM20948_DLPF_0 - ICM20948_DLPF_7 and ICM20948_DLPF_OFF
+static const uint16_t icm20948_accel_group_delay[9] PROGMEM = {647, 647, 1429, 3158, 6659, 13840, 27922, 336, 132};
+
+// Number of frames at which the FIFO should be drained, compared in software by icm20948_fifo_watermark_reached
+static uint8_t icm20948_fifo_watermark = 1;
+
+// Set when data in the FIFO was lost
+static uint8_t icm20948_fifo_overflow = 0;
+
+// User bank selected in ICM20948_REG_BANK_SEL, 0xFF if unknown
+static uint8_t icm20948_current_bank = 0xFF;
+
+/**
+ * @brief Send the start of a transaction addressing a register of the currently selected bank.
+ *
+ * @param[in] register_address The register to access.
+ */
+static void icm20948_start_transaction(uint8_t register_address)
+{
     i2c_master_start();
     i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_ACCEL_XOUT_H);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+    i2c_master_sendChar(register_address);
 }
 
-uint16_t icm20948_get_accelerometer_y_raw()
+void icm20948_select_bank(uint8_t bank)
 {
-    uint16_t data = 0;
+    // ICM20948_REG_BANK_SEL is available in every bank, so only write it if the bank really changes
+    if (bank != icm20948_current_bank)
+    {
+        icm20948_start_transaction(ICM20948_REG_BANK_SEL);
+        i2c_master_sendChar(bank << 4);
+        i2c_master_stop();
+        icm20948_current_bank = bank;
+    }
+}
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_ACCEL_YOUT_H);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+void icm20948_invalidate_bank()
+{
+    icm20948_current_bank = 0xFF;
 }
 
-uint16_t icm20948_get_accelerometer_z_raw()
+void icm20948_read_registers(uint8_t bank, uint8_t register_address, uint8_t data[], uint8_t length)
 {
-    uint16_t data = 0;
+    if (length == 0)
+    {
+        return;
+    }
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_ACCEL_ZOUT_H);
+    icm20948_select_bank(bank);
+    icm20948_start_transaction(register_address);
     i2c_master_start();
     i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
+    for (uint8_t index = 0; index < length - 1; index++)
+    {
+        data[index] = i2c_master_receiveChar(0x01);    // ACK all bytes but the last one
+    }
+    data[length - 1] = i2c_master_receiveChar(0x00);
     i2c_master_stop();
-    return data;
 }
 
+uint8_t icm20948_read_register(uint8_t bank, uint8_t register_address)
+{
+    uint8_t value;
 
-uint16_t icm20948_get_gyro_x_raw()
+    icm20948_read_registers(bank, register_address, &value, 1);
+    return value;
+}
+
+void icm20948_write_registers(uint8_t bank, uint8_t register_address, const uint8_t data[], uint8_t length)
 {
-    uint16_t data = 0;
+    icm20948_select_bank(bank);
+    icm20948_start_transaction(register_address);
+    for (uint8_t index = 0; index < length; index++)
+    {
+        i2c_master_sendChar(data[index]);
+    }
+    i2c_master_stop();
+}
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_GYRO_XOUT_H);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
+void icm20948_write_register(uint8_t bank, uint8_t register_address, uint8_t value)
+{
+    icm20948_select_bank(bank);
+    icm20948_start_transaction(register_address);
+    i2c_master_sendChar(value);
     i2c_master_stop();
-    return data;
 }
 
-uint16_t icm20948_get_gyro_y_raw()
+void icm20948_modify_register(uint8_t bank, uint8_t register_address, uint8_t mask, uint8_t value)
 {
-    uint16_t data = 0;
+    uint8_t data = icm20948_read_register(bank, register_address);
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_GYRO_YOUT_H);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+    icm20948_write_register(bank, register_address, (data & ~mask) | (value & mask));
 }
 
-uint16_t icm20948_get_gyro_z_raw()
+/**
+ * @brief Build the value of GYRO_CONFIG_1 or ACCEL_CONFIG.
+ *
+ * @param[in] range The full scale range (0-3).
+ * @param[in] dlpf The low pass filter setting (0-7 or ICM20948_DLPF_OFF).
+ * @return DLPFCFG in bits 5:3, FS_SEL in bits 2:1 and FCHOICE in bit 0.
+ */
+static uint8_t icm20948_filter_config(uint8_t range, uint8_t dlpf)
 {
-    uint16_t data = 0;
+    if (dlpf == ICM20948_DLPF_OFF)
+    {
+        return (range & 0x03) << 1;
+    }
+    return ((dlpf & 0x07) << 3) | ((range & 0x03) << 1) | 0x01;
+}
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_GYRO_ZOUT_H);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+void icm20948_configure(const struct icm20948_config *config)
+{
+    // Wake up, leave the low power mode and let the device select the best clock source
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_1, 0x01);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_2, 0x00);
+
+    // Continuous sampling, the duty-cycled mode would ignore the filter settings below
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_LP_CONFIG, 0x00);
+    _delay_ms(1);
+
+    // GYRO_SMPLRT_DIV and GYRO_CONFIG_1 are consecutive, so are ACCEL_SMPLRT_DIV_1 and _2
+    uint8_t gyro[2] = {config->gyro_divider, icm20948_filter_config(config->gyro_range, config->gyro_dlpf)};
+    uint8_t accel_divider[2] = {(config->accel_divider >> 8) & 0x0F, config->accel_divider};
+
+    icm20948_write_registers(ICM20948_BANK_2, ICM20948_REG_GYRO_SMPLRT_DIV, gyro, 2);
+    icm20948_write_registers(ICM20948_BANK_2, ICM20948_REG_ACCEL_SMPLRT_DIV_1, accel_divider, 2);
+    icm20948_write_register(ICM20948_BANK_2, ICM20948_REG_ACCEL_CONFIG, icm20948_filter_config(config->accel_range, config->accel_dlpf));
+    icm20948_write_register(ICM20948_BANK_2, ICM20948_REG_ODR_ALIGN_EN, 0x01);
 }
 
+uint32_t icm20948_get_gyro_odr_millihertz(const struct icm20948_config *config)
+{
+    if (config->gyro_dlpf == ICM20948_DLPF_OFF)
+    {
+        return 9000000UL;
+    }
+    return 1125000UL / (1 + config->gyro_divider);
+}
 
-uint16_t icm20948_get_magnetometer_x_raw()
+uint32_t icm20948_get_accel_odr_millihertz(const struct icm20948_config *config)
 {
-    //TEST: If AK09916 can print out multiple values continuously
+    if (config->accel_dlpf == ICM20948_DLPF_OFF)
+    {
+        return 4500000UL;
+    }
+    return 1125000UL / (1 + (config->accel_divider & 0x0FFF));
+}
 
-    uint16_t data = 0;
+uint16_t icm20948_get_gyro_group_delay_us(const struct icm20948_config *config)
+{
+    uint8_t index = (config->gyro_dlpf == ICM20948_DLPF_OFF) ? 8 : (config->gyro_dlpf & 0x07);
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_AK09916_REG_MAG_XOUT_L);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+    return pgm_read_word(&icm20948_gyro_group_delay[index]);
 }
 
-uint16_t icm20948_get_magnetometer_y_raw()
+uint16_t icm20948_get_accel_group_delay_us(const struct icm20948_config *config)
 {
-    //TEST: If AK09916 can print out multiple values continuously
+    uint8_t index = (config->accel_dlpf == ICM20948_DLPF_OFF) ? 8 : (config->accel_dlpf & 0x07);
 
-    uint16_t data = 0;
+    return pgm_read_word(&icm20948_accel_group_delay[index]);
+}
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_AK09916_REG_MAG_YOUT_L);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+void icm20948_accel_duty_cycle_start(uint16_t accel_divider)
+{
+    uint8_t divider[2] = {(accel_divider >> 8) & 0x0F, accel_divider};
+
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_1, 0x01);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_2, ICM20948_PWR_MGMT_2_GYRO_OFF);
+    icm20948_write_registers(ICM20948_BANK_2, ICM20948_REG_ACCEL_SMPLRT_DIV_1, divider, 2);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_LP_CONFIG, ICM20948_LP_CONFIG_ACCEL_CYCLE);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_1, ICM20948_PWR_MGMT_1_LP_EN | 0x01);
 }
 
-uint16_t icm20948_get_magnetometer_z_raw()
+void icm20948_wake_on_motion_start(uint16_t threshold_mg, uint16_t accel_divider)
 {
-    //TEST: If AK09916 can print out multiple values continuously
+    uint16_t threshold = threshold_mg / 4;
 
-    uint16_t data = 0;
+    icm20948_accel_duty_cycle_start(accel_divider);
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_AK09916_REG_MAG_ZOUT_L);
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_AK09916_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
-    i2c_master_stop();
-    return data;
+    // Active low, push-pull, held until ICM20948_REG_INT_STATUS is read
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_INT_PIN_CFG, ICM20948_INT_PIN_CFG_ACTL | ICM20948_INT_PIN_CFG_LATCH_EN);
+    icm20948_write_register(ICM20948_BANK_2, ICM20948_REG_ACCEL_WOM_THR, (threshold > 255) ? 255 : threshold);
+    icm20948_write_register(ICM20948_BANK_2, ICM20948_REG_ACCEL_INTEL_CTRL, ICM20948_ACCEL_INTEL_EN | ICM20948_ACCEL_INTEL_MODE_INT);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_INT_ENABLE, ICM20948_INT_WOM);
+
+    // Release the pin in case it is still active
+    icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_INT_STATUS);
+#ifdef ICM20948_INTERRUPT
+    icm20948_interrupt_flag = 0;
+    icm20948_interrupt_enable();
+#endif
 }
 
+void icm20948_wake_on_motion_stop()
+{
+#ifdef ICM20948_INTERRUPT
+    GICR &= ~ICM20948_INTERRUPT_ENABLE;
+#endif
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_INT_ENABLE, 0x00);
+    icm20948_write_register(ICM20948_BANK_2, ICM20948_REG_ACCEL_INTEL_CTRL, 0x00);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_1, 0x01);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_LP_CONFIG, 0x00);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_PWR_MGMT_2, 0x00);   // Gyroscope on again
+    icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_INT_STATUS);
+}
+
+uint8_t icm20948_motion_detected()
+{
+    uint8_t status;
+
+#ifdef ICM20948_INTERRUPT
+    if (!icm20948_interrupt_flag)
+    {
+        return 0;
+    }
+    icm20948_interrupt_flag = 0;
+#endif
+
+    // Reading the status releases the INT pin
+    status = icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_INT_STATUS);
+
+#ifdef ICM20948_INTERRUPT
+    icm20948_interrupt_enable();
+#endif
+
+    return (status & ICM20948_INT_WOM) ? 1 : 0;
+}
+
+uint8_t icm20948_calibrate(const struct icm20948_config *config, uint16_t samples, struct icm20948_calibration *calibration)
+{
+    int32_t sum[6] = {0, 0, 0, 0, 0, 0};
+    struct icm20948_sample sample;
+    uint8_t data[6];
+
+    // Two sample periods of the gyroscope and some margin
+    uint16_t timeout_ms = (uint16_t)(2000000UL / icm20948_get_gyro_odr_millihertz(config)) + 2;
+
+    // Not valid until all samples are measured
+    calibration->magic = 0;
+
+    // At least one sample, the bias is divided by the number of samples
+    if (samples == 0)
+    {
+        samples = 1;
+    }
+
+    // Start from the offsets currently in the registers, the measured bias already includes them
+    icm20948_read_registers(ICM20948_BANK_2, ICM20948_REG_XG_OFFS_H, data, 6);
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        calibration->gyro_offset[axis] = (int16_t)((data[2*axis] << 8) | data[2*axis + 1]);
+    }
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        // The accelerometer offsets are 3 registers apart
+        icm20948_read_registers(ICM20948_BANK_1, ICM20948_REG_XA_OFFS_H + 3*axis, data, 2);
+        calibration->accel_offset[axis] = (int16_t)((data[0] << 8) | data[1]);
+    }
+
+    // Discard data that is already waiting
+    icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_INT_STATUS_1);
+    for (uint16_t n = 0; n < samples; n++)
+    {
+        // Wait for RAW_DATA_0_RDY, the sensor may be asleep or not answer
+        uint16_t waited = 0;
+        while (!(icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_INT_STATUS_1) & 0x01))
+        {
+            if (waited++ >= timeout_ms)
+            {
+                return 0;
+            }
+            _delay_ms(1);
+        }
+        icm20948_read_sample(&sample);
+        for (uint8_t axis = 0; axis < 3; axis++)
+        {
+            sum[axis] += sample.gyro[axis];
+            sum[3 + axis] += sample.accel[axis];
+        }
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        int32_t gyro_bias = sum[axis] / (int32_t)samples;
+        int32_t accel_bias = sum[3 + axis] / (int32_t)samples;
+
+        // Gravity: 16384 LSB per g at +-2 g, the z-axis has to point up
+        if (axis == 2)
+        {
+            accel_bias -= 16384 >> config->accel_range;
+        }
+
+        // Gyroscope offset: 4 LSB at +-250 dps are 1 LSB of the offset
+        calibration->gyro_offset[axis] -= (int16_t)((gyro_bias << config->gyro_range) / 4);
+
+        // Accelerometer offset: 16 LSB at +-2 g are 1 step of the offset, which is stored in bits 15 - 1
+        calibration->accel_offset[axis] -= (int16_t)(((accel_bias << config->accel_range) / 16) * 2);
+    }
+
+    calibration->magic = ICM20948_CALIBRATION_MAGIC;
+    icm20948_apply_calibration(calibration);
+    return 1;
+}
+
+void icm20948_apply_calibration(const struct icm20948_calibration *calibration)
+{
+    uint8_t data[6];
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        data[2*axis] = (uint16_t)calibration->gyro_offset[axis] >> 8;
+        data[2*axis + 1] = calibration->gyro_offset[axis] & 0xFF;
+    }
+    icm20948_write_registers(ICM20948_BANK_2, ICM20948_REG_XG_OFFS_H, data, 6);
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        // Keep the reserved bit 0
+        uint8_t reserved = icm20948_read_register(ICM20948_BANK_1, ICM20948_REG_XA_OFFS_L + 3*axis) & 0x01;
+
+        data[0] = (uint16_t)calibration->accel_offset[axis] >> 8;
+        data[1] = (calibration->accel_offset[axis] & 0xFE) | reserved;
+        icm20948_write_registers(ICM20948_BANK_1, ICM20948_REG_XA_OFFS_H + 3*axis, data, 2);
+    }
+}
+
+void icm20948_save_calibration(const struct icm20948_calibration *calibration, struct icm20948_calibration *eeprom)
+{
+    eeprom_update_block(calibration, eeprom, sizeof(struct icm20948_calibration));
+}
+
+uint8_t icm20948_load_calibration(const struct icm20948_calibration *eeprom)
+{
+    struct icm20948_calibration calibration;
+
+    eeprom_read_block(&calibration, eeprom, sizeof(struct icm20948_calibration));
+    if (calibration.magic != ICM20948_CALIBRATION_MAGIC)
+    {
+        return 0;
+    }
+    icm20948_apply_calibration(&calibration);
+    return 1;
+}
+
+/**
+ * @brief Read a 16-bit big endian value from two consecutive registers of user bank 0.
+ *
+ * @param[in] register_address The register holding the high byte.
+ * @return The value of both registers.
+ */
+static uint16_t icm20948_read_word(uint8_t register_address)
+{
+    uint8_t data[2];
+
+    icm20948_read_registers(ICM20948_BANK_0, register_address, data, 2);
+    return (uint16_t)((data[0] << 8) | data[1]);
+}
+
+/**
+ * @brief Transfer a single byte from or to the AK09916 using slave 4 of the internal I2C master.
+ *
+ * @param[in] address ICM20948_AK09916_I2C_ADDRESS, optionally combined with ICM20948_I2C_SLV_READ.
+ * @param[in] register_address The register of the AK09916.
+ * @param[in] value The value to write, ignored for reads.
+ * @return The byte read or 0xFF if the transfer did not finish.
+ */
+static uint8_t icm20948_magnetometer_transfer(uint8_t address, uint8_t register_address, uint8_t value)
+{
+    uint8_t status = 0;
+
+    // I2C_SLV4_ADDR and I2C_SLV4_REG are consecutive, I2C_SLV4_DO follows I2C_SLV4_CTRL
+    uint8_t transfer[2] = {address, register_address};
+
+    icm20948_write_registers(ICM20948_BANK_3, ICM20948_REG_I2C_SLV4_ADDR, transfer, 2);
+    icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV4_DO, value);
+
+    // Enable last, the transfer may start as soon as I2C_SLV4_EN is set
+    icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV4_CTRL, ICM20948_I2C_SLV_EN);
+
+    // Wait until the internal I2C master has finished the transfer (at most ~10 ms)
+    for (uint8_t retry = 0; retry < 10 && !(status & ICM20948_I2C_MST_STATUS_SLV4_DONE); retry++)
+    {
+        _delay_ms(1);
+        status = icm20948_read_register(ICM20948_BANK_0, ICM20948_REG_I2C_MST_STATUS);
+    }
+    if (!(status & ICM20948_I2C_MST_STATUS_SLV4_DONE))
+    {
+        return 0xFF;
+    }
+
+    return icm20948_read_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV4_DI);
+}
+
+uint8_t icm20948_magnetometer_start()
+{
+    // Enable the internal I2C master
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_I2C_MST_EN, ICM20948_USER_CTRL_I2C_MST_EN);
+
+    icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_MST_CTRL, 0x07);          // 345.6 kHz, recommended by the datasheet
+    icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_MST_ODR_CONFIG, 0x03);    // 1.1 kHz / 2^3 = 137.5 Hz, faster than the AK09916
+
+    if (icm20948_magnetometer_transfer(ICM20948_AK09916_I2C_ADDRESS | ICM20948_I2C_SLV_READ, ICM20948_AK09916_REG_WIA2, 0x00) != ICM20948_AK09916_DEVICE_ID)
+    {
+        return 0;
+    }
+
+    // Reset the AK09916 and start continuous measurements
+    icm20948_magnetometer_transfer(ICM20948_AK09916_I2C_ADDRESS, ICM20948_AK09916_REG_CNTL3, 0x01);
+    _delay_ms(1);
+    icm20948_magnetometer_transfer(ICM20948_AK09916_I2C_ADDRESS, ICM20948_AK09916_REG_CNTL2, ICM20948_AK09916_MODE_CONTINUOUS_100HZ);
+
+    // Let slave 0 copy HXL..ST2 to EXT_SLV_SENS_DATA_00..07 on every cycle of the I2C master
+    uint8_t slave[3] = {ICM20948_AK09916_I2C_ADDRESS | ICM20948_I2C_SLV_READ, ICM20948_AK09916_REG_MAG_XOUT_L, ICM20948_I2C_SLV_EN | ICM20948_AK09916_READ_LENGTH};
+    icm20948_write_registers(ICM20948_BANK_3, ICM20948_REG_I2C_SLV0_ADDR, slave, 3);
+
+    return 1;
+}
+
+void icm20948_read_sample(struct icm20948_sample *sample)
+{
+    uint8_t data[ICM20948_SAMPLE_LENGTH];
+
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_ACCEL_XOUT_H, data, ICM20948_SAMPLE_LENGTH);
+
+    // Output registers are stored big endian: high byte first
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        sample->accel[axis] = (int16_t)((data[2*axis] << 8) | data[2*axis + 1]);
+        sample->gyro[axis] = (int16_t)((data[6 + 2*axis] << 8) | data[6 + 2*axis + 1]);
+    }
+    sample->temperature = (int16_t)((data[12] << 8) | data[13]);
+}
+
+void icm20948_read_sample_9axis(struct icm20948_sample *sample)
+{
+    uint8_t data[ICM20948_SAMPLE_9AXIS_LENGTH];
+
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_ACCEL_XOUT_H, data, ICM20948_SAMPLE_9AXIS_LENGTH);
+
+    // Output registers are stored big endian, the copied AK09916 registers little endian
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        sample->accel[axis] = (int16_t)((data[2*axis] << 8) | data[2*axis + 1]);
+        sample->gyro[axis] = (int16_t)((data[6 + 2*axis] << 8) | data[6 + 2*axis + 1]);
+        sample->mag[axis] = (int16_t)((data[14 + 2*axis + 1] << 8) | data[14 + 2*axis]);
+    }
+    sample->temperature = (int16_t)((data[12] << 8) | data[13]);
+}
+
+uint16_t icm20948_get_accelerometer_x_raw()
+{
+    return icm20948_read_word(ICM20948_REG_ACCEL_XOUT_H);
+}
+
+uint16_t icm20948_get_accelerometer_y_raw()
+{
+    return icm20948_read_word(ICM20948_REG_ACCEL_YOUT_H);
+}
+
+uint16_t icm20948_get_accelerometer_z_raw()
+{
+    return icm20948_read_word(ICM20948_REG_ACCEL_ZOUT_H);
+}
+
+
+uint16_t icm20948_get_gyro_x_raw()
+{
+    return icm20948_read_word(ICM20948_REG_GYRO_XOUT_H);
+}
+
+uint16_t icm20948_get_gyro_y_raw()
+{
+    return icm20948_read_word(ICM20948_REG_GYRO_YOUT_H);
+}
+
+uint16_t icm20948_get_gyro_z_raw()
+{
+    return icm20948_read_word(ICM20948_REG_GYRO_ZOUT_H);
+}
+
+
+uint16_t icm20948_get_magnetometer_x_raw()
+{
+    uint8_t data[2];
+
+    // The internal I2C master has already copied the AK09916 registers (little endian)
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_EXT_SLV_SENS_DATA_00, data, 2);
+    return (uint16_t)((data[1] << 8) | data[0]);
+}
+
+uint16_t icm20948_get_magnetometer_y_raw()
+{
+    uint8_t data[2];
+
+    // The internal I2C master has already copied the AK09916 registers (little endian)
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_EXT_SLV_SENS_DATA_00 + 2, data, 2);
+    return (uint16_t)((data[1] << 8) | data[0]);
+}
+
+uint16_t icm20948_get_magnetometer_z_raw()
+{
+    uint8_t data[2];
+
+    // The internal I2C master has already copied the AK09916 registers (little endian)
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_EXT_SLV_SENS_DATA_00 + 4, data, 2);
+    return (uint16_t)((data[1] << 8) | data[0]);
+}
 
 //TODO: rework datatypes if needed
 float icm20948_get_temperature()
@@ -170,15 +586,104 @@ uint16_t icm20948_get_temperature_raw()
 {
     //TEST: If AK09916 can print out multiple values continuously
 
-    uint16_t data = 0;
+    return icm20948_read_word(ICM20948_REG_TEMP_OUT_H);
+}
 
-    i2c_master_start();
-    i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x00);
-    i2c_master_sendChar(ICM20948_REG_TEMP_OUT_H);
+void icm20948_fifo_start(uint8_t watermark)
+{
+    icm20948_fifo_watermark = watermark;
+    icm20948_fifo_overflow = 0;
+
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_MODE, 0x00);     // Stream mode
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_EN_2, ICM20948_FIFO_EN_2_ACCEL_GYRO);
+    icm20948_fifo_reset();
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_FIFO_EN, ICM20948_USER_CTRL_FIFO_EN);
+}
+
+void icm20948_fifo_stop()
+{
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_EN_2, 0x00);
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_FIFO_EN, 0x00);
+}
+
+void icm20948_fifo_reset()
+{
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_RST, 0x1F);     // Assert reset
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_RST, 0x00);     // Release reset
+}
+
+/**
+ * @brief Read the number of bytes in the FIFO.
+ *
+ * @return The content of FIFO_COUNTH and FIFO_COUNTL.
+ */
+static uint16_t icm20948_fifo_count()
+{
+    return icm20948_read_word(ICM20948_REG_FIFO_COUNTH) & 0x1FFF;
+}
+
+uint8_t icm20948_fifo_frames()
+{
+    return icm20948_fifo_count() / ICM20948_FIFO_FRAME_LENGTH;
+}
+
+uint8_t icm20948_fifo_watermark_reached()
+{
+    return icm20948_fifo_frames() >= icm20948_fifo_watermark;
+}
+
+uint8_t icm20948_fifo_read(struct icm20948_sample samples[], uint8_t max)
+{
+    uint16_t count = icm20948_fifo_count();
+    uint8_t frames = count / ICM20948_FIFO_FRAME_LENGTH;
+    uint8_t data[ICM20948_FIFO_FRAME_LENGTH];
+
+    // A full FIFO in stream mode overwrites its oldest bytes, so the frame boundaries are unknown
+    if (count >= ICM20948_FIFO_SIZE)
+    {
+        icm20948_fifo_reset();
+        icm20948_fifo_overflow = 1;
+        return 0;
+    }
+
+    if (frames > max)
+    {
+        frames = max;
+    }
+    if (frames == 0)
+    {
+        return 0;
+    }
+
+    // Drain all frames in one burst, only the very last byte gets a NACK
+    icm20948_select_bank(ICM20948_BANK_0);
+    icm20948_start_transaction(ICM20948_REG_FIFO_R_W);
     i2c_master_start();
     i2c_master_sendAddress(ICM20948_I2C_ADDRESS, 0x01);
-    data = (i2c_master_receiveChar(0x01)<<8);
-    data |= i2c_master_receiveChar(0x00);
+    for (uint8_t frame = 0; frame < frames; frame++)
+    {
+        for (uint8_t index = 0; index < ICM20948_FIFO_FRAME_LENGTH; index++)
+        {
+            data[index] = i2c_master_receiveChar(frame != frames - 1 || index != ICM20948_FIFO_FRAME_LENGTH - 1);
+        }
+        for (uint8_t axis = 0; axis < 3; axis++)
+        {
+            samples[frame].accel[axis] = (int16_t)((data[2*axis] << 8) | data[2*axis + 1]);
+            samples[frame].gyro[axis] = (int16_t)((data[6 + 2*axis] << 8) | data[6 + 2*axis + 1]);
+            samples[frame].mag[axis] = 0;
+        }
+        // Only accelerometer and gyroscope are written to the FIFO
+        samples[frame].temperature = 0;
+    }
     i2c_master_stop();
-    return data;
+
+    return frames;
+}
+
+uint8_t icm20948_fifo_overflowed()
+{
+    uint8_t overflow = icm20948_fifo_overflow;
+
+    icm20948_fifo_overflow = 0;
+    return overflow;
 }
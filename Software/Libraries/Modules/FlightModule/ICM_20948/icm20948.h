@@ -10,6 +10,24 @@
 #define ICM20948_H_
 
 #include "i2c_master.h"
+#include "icm20948_sample.h"
+
+
+/**
+* @def ICM20948_INTERRUPT
+* @brief Use an external interrupt of the ATmega16A for the INT pin of the ICM20948.
+*
+* @note: The value selects the pin: 0 = INT0 (PD2), 1 = INT1 (PD3), 2 = INT2 (PB2). Global interrupts have to be enabled with sei().
+* INT0 and INT1 are used as low level interrupts, as only these wake the MCU from power-down.
+*
+* Without this define `icm20948_motion_detected` polls ICM20948_REG_INT_STATUS over I2C.
+*
+* To enable, uncomment the following line:
+* @code
+* #define ICM20948_INTERRUPT 0
+* @endcode
+*/
+//#define ICM20948_INTERRUPT 0
 
 /**
  * @def ICM20948_I2C_ADDRESS
@@ -125,47 +143,576 @@
  */
 #define ICM20948_REG_TEMP_OUT_L         0x3A
 
+/**
+ * @def ICM20948_AK09916_REG_MAG_XOUT_L
+ * 
+ * This value is used to read the low byte of the magnetometer data for the X-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
+ */
+#define ICM20948_AK09916_REG_MAG_XOUT_L 0x11
+
 /**
  * @def ICM20948_AK09916_REG_MAG_XOUT_H
  * 
  * This value is used to read the high byte of the magnetometer data for the X-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
  */
-#define ICM20948_AK09916_REG_MAG_XOUT_H 0x11
+#define ICM20948_AK09916_REG_MAG_XOUT_H 0x12
 
 /**
- * @def ICM20948_AK09916_REG_MAG_XOUT_L
+ * @def ICM20948_AK09916_REG_MAG_YOUT_L
  * 
- * This value is used to read the low byte of the magnetometer data for the X-axis
+ * This value is used to read the low byte of the magnetometer data for the Y-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
  */
-#define ICM20948_AK09916_REG_MAG_XOUT_L 0x12
+#define ICM20948_AK09916_REG_MAG_YOUT_L 0x13
 
 /**
  * @def ICM20948_AK09916_REG_MAG_YOUT_H
  * 
  * This value is used to read the high byte of the magnetometer data for the Y-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
  */
-#define ICM20948_AK09916_REG_MAG_YOUT_H 0x13
+#define ICM20948_AK09916_REG_MAG_YOUT_H 0x14
 
 /**
- * @def ICM20948_AK09916_REG_MAG_YOUT_L
+ * @def ICM20948_AK09916_REG_MAG_ZOUT_L
  * 
- * This value is used to read the low byte of the magnetometer data for the Y-axis
+ * This value is used to read the low byte of the magnetometer data for the Z-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
  */
-#define ICM20948_AK09916_REG_MAG_YOUT_L 0x14
+#define ICM20948_AK09916_REG_MAG_ZOUT_L 0x15
 
 /**
  * @def ICM20948_AK09916_REG_MAG_ZOUT_H
  * 
  * This value is used to read the high byte of the magnetometer data for the Z-axis
+ * @note The AK09916 stores its data little endian: the low byte comes first.
  */
-#define ICM20948_AK09916_REG_MAG_ZOUT_H 0x15
+#define ICM20948_AK09916_REG_MAG_ZOUT_H 0x16
 
 /**
- * @def ICM20948_AK09916_REG_MAG_ZOUT_L
+ * @def ICM20948_AK09916_REG_WIA2
  * 
- * This value is used to read the low byte of the magnetometer data for the Z-axis
+ * This value is used to read the device ID of the AK09916 (always ICM20948_AK09916_DEVICE_ID)
+ */
+#define ICM20948_AK09916_REG_WIA2       0x01
+
+/**
+ * @def ICM20948_AK09916_REG_RSV2
+ * 
+ * This value is used to start the read of the DMP compass data. Reading on from RSV2 continues at ST1.
+ */
+#define ICM20948_AK09916_REG_RSV2       0x03
+
+/**
+ * @def ICM20948_AK09916_REG_CNTL2
+ * 
+ * This value is used to set the operation mode of the AK09916
+ */
+#define ICM20948_AK09916_REG_CNTL2      0x31
+
+/**
+ * @def ICM20948_AK09916_REG_CNTL3
+ * 
+ * This value is used to reset the AK09916
+ */
+#define ICM20948_AK09916_REG_CNTL3      0x32
+
+/**
+ * @def ICM20948_AK09916_DEVICE_ID
+ * 
+ * Content of ICM20948_AK09916_REG_WIA2
+ */
+#define ICM20948_AK09916_DEVICE_ID      0x09
+
+/**
+ * @def ICM20948_AK09916_MODE_CONTINUOUS_100HZ
+ * 
+ * Operation mode for ICM20948_AK09916_REG_CNTL2: continuous measurement at 100 Hz
+ */
+#define ICM20948_AK09916_MODE_CONTINUOUS_100HZ 0x08
+
+/**
+ * @def ICM20948_AK09916_MODE_POWER_DOWN
+ * 
+ * Operation mode for ICM20948_AK09916_REG_CNTL2: power down, required between two other modes
+ */
+#define ICM20948_AK09916_MODE_POWER_DOWN 0x00
+
+/**
+ * @def ICM20948_AK09916_MODE_SINGLE
+ * 
+ * Operation mode for ICM20948_AK09916_REG_CNTL2: a single measurement, triggered by the DMP
+ */
+#define ICM20948_AK09916_MODE_SINGLE    0x01
+
+/**
+ * @def ICM20948_AK09916_READ_LENGTH
+ *
+ * Number of bytes the internal I2C master reads from the AK09916 starting at ICM20948_AK09916_REG_MAG_XOUT_L.
+ * Besides the 6 data bytes this includes TMPS and ST2. Reading ST2 is required to release the data registers for the next measurement.
+ */
+#define ICM20948_AK09916_READ_LENGTH    8
+
+/**
+ * @defgroup ICM20948_BANKS ICM20948 User Banks
+ * @brief The registers of the ICM20948 are split into four user banks.
+ *
+ * ICM20948_REG_BANK_SEL selects the bank all other register addresses refer to.
+ * The driver remembers the selected bank and only writes ICM20948_REG_BANK_SEL if it changes.
+ *
+ * @{
+ */
+#define ICM20948_BANK_0                 0
+#define ICM20948_BANK_1                 1
+#define ICM20948_BANK_2                 2
+#define ICM20948_BANK_3                 3
+
+/** @} */
+
+/**
+ * @def ICM20948_REG_USER_CTRL
+ * 
+ * This value is used to enable the FIFO, the internal I2C master and the DMP (user bank 0)
+ */
+#define ICM20948_REG_USER_CTRL          0x03
+
+/**
+ * @def ICM20948_USER_CTRL_I2C_MST_EN
+ * 
+ * Bit in ICM20948_REG_USER_CTRL which enables the internal I2C master
+ */
+#define ICM20948_USER_CTRL_I2C_MST_EN   (1 << 5)
+
+/**
+ * @def ICM20948_REG_PWR_MGMT_1
+ * 
+ * This value is used to reset the device, wake it up and select the clock source (user bank 0)
+ */
+#define ICM20948_REG_PWR_MGMT_1         0x06
+
+/**
+ * @def ICM20948_REG_PWR_MGMT_2
+ * 
+ * This value is used to enable or disable the axes of the accelerometer and gyroscope (user bank 0)
+ */
+#define ICM20948_REG_PWR_MGMT_2         0x07
+
+/**
+ * @def ICM20948_REG_GYRO_SMPLRT_DIV
+ * 
+ * This value is used to set the gyroscope sample rate divider (user bank 2)
+ */
+#define ICM20948_REG_GYRO_SMPLRT_DIV    0x00
+
+/**
+ * @def ICM20948_REG_GYRO_CONFIG_1
+ * 
+ * This value is used to set the full scale range and low pass filter of the gyroscope (user bank 2)
+ */
+#define ICM20948_REG_GYRO_CONFIG_1      0x01
+
+/**
+ * @def ICM20948_REG_ODR_ALIGN_EN
+ * 
+ * This value is used to align the output data rates of all sensors (user bank 2)
+ */
+#define ICM20948_REG_ODR_ALIGN_EN       0x09
+
+/**
+ * @def ICM20948_REG_ACCEL_SMPLRT_DIV_1
+ * 
+ * This value is used to set the upper 4 bits of the accelerometer sample rate divider (user bank 2)
+ */
+#define ICM20948_REG_ACCEL_SMPLRT_DIV_1 0x10
+
+/**
+ * @def ICM20948_REG_ACCEL_SMPLRT_DIV_2
+ * 
+ * This value is used to set the lower 8 bits of the accelerometer sample rate divider (user bank 2)
+ */
+#define ICM20948_REG_ACCEL_SMPLRT_DIV_2 0x11
+
+/**
+ * @def ICM20948_REG_ACCEL_CONFIG
+ * 
+ * This value is used to set the full scale range and low pass filter of the accelerometer (user bank 2)
+ */
+#define ICM20948_REG_ACCEL_CONFIG       0x14
+
+/**
+ * @def ICM20948_REG_ACCEL_INTEL_CTRL
+ * 
+ * This value is used to enable the wake-on-motion logic (user bank 2)
+ */
+#define ICM20948_REG_ACCEL_INTEL_CTRL   0x12
+
+/**
+ * @def ICM20948_ACCEL_INTEL_EN
+ *
+ * Bit in ICM20948_REG_ACCEL_INTEL_CTRL which enables the wake-on-motion logic
+ */
+#define ICM20948_ACCEL_INTEL_EN         (1 << 1)
+
+/**
+ * @def ICM20948_ACCEL_INTEL_MODE_INT
+ *
+ * Bit in ICM20948_REG_ACCEL_INTEL_CTRL which compares every sample with the previous one instead of the first one
+ */
+#define ICM20948_ACCEL_INTEL_MODE_INT   (1 << 0)
+
+/**
+ * @def ICM20948_REG_ACCEL_WOM_THR
+ * 
+ * This value is used to set the wake-on-motion threshold in 4 mg steps (user bank 2)
+ */
+#define ICM20948_REG_ACCEL_WOM_THR      0x13
+
+/**
+ * @def ICM20948_REG_LP_CONFIG
+ * 
+ * This value is used to switch sensors to duty-cycled operation (user bank 0)
+ */
+#define ICM20948_REG_LP_CONFIG          0x05
+
+/**
+ * @def ICM20948_LP_CONFIG_ACCEL_CYCLE
+ *
+ * Bit in ICM20948_REG_LP_CONFIG which duty-cycles the accelerometer
+ */
+#define ICM20948_LP_CONFIG_ACCEL_CYCLE  (1 << 5)
+
+/**
+ * @def ICM20948_PWR_MGMT_1_LP_EN
+ *
+ * Bit in ICM20948_REG_PWR_MGMT_1 which turns on the low power mode of the digital circuits
+ */
+#define ICM20948_PWR_MGMT_1_LP_EN       (1 << 5)
+
+/**
+ * @def ICM20948_PWR_MGMT_2_GYRO_OFF
+ *
+ * Value of ICM20948_REG_PWR_MGMT_2 which turns off all gyroscope axes and keeps the accelerometer on
+ */
+#define ICM20948_PWR_MGMT_2_GYRO_OFF    0x07
+
+/**
+ * @def ICM20948_REG_INT_PIN_CFG
+ * 
+ * This value is used to set the electrical behaviour of the INT pin (user bank 0)
+ */
+#define ICM20948_REG_INT_PIN_CFG        0x0F
+
+/**
+ * @def ICM20948_INT_PIN_CFG_ACTL
+ *
+ * Bit in ICM20948_REG_INT_PIN_CFG which makes the INT pin active low
+ */
+#define ICM20948_INT_PIN_CFG_ACTL       (1 << 7)
+
+/**
+ * @def ICM20948_INT_PIN_CFG_LATCH_EN
+ *
+ * Bit in ICM20948_REG_INT_PIN_CFG which keeps the INT pin active until the interrupt status is read
+ */
+#define ICM20948_INT_PIN_CFG_LATCH_EN   (1 << 5)
+
+/**
+ * @def ICM20948_REG_INT_ENABLE
+ * 
+ * This value is used to select the interrupts routed to the INT pin (user bank 0)
+ */
+#define ICM20948_REG_INT_ENABLE         0x10
+
+/**
+ * @def ICM20948_REG_INT_STATUS
+ * 
+ * This value is used to read the interrupt status. Reading clears it (user bank 0)
+ */
+#define ICM20948_REG_INT_STATUS         0x19
+
+/**
+ * @def ICM20948_INT_WOM
+ *
+ * Bit for the wake-on-motion interrupt in ICM20948_REG_INT_ENABLE and ICM20948_REG_INT_STATUS
+ */
+#define ICM20948_INT_WOM                (1 << 3)
+
+/**
+ * @defgroup ICM20948_GYRO_RANGE ICM20948 Gyroscope Full Scale Range
+ * @brief Values for `icm20948_config.gyro_range`.
+ *
+ * - `ICM20948_GYRO_RANGE_250DPS`  (0): +-250 dps, 131 LSB/dps
+ * - `ICM20948_GYRO_RANGE_500DPS`  (1): +-500 dps, 65.5 LSB/dps
+ * - `ICM20948_GYRO_RANGE_1000DPS` (2): +-1000 dps, 32.8 LSB/dps
+ * - `ICM20948_GYRO_RANGE_2000DPS` (3): +-2000 dps, 16.4 LSB/dps
+ *
+ * @{
+ */
+#define ICM20948_GYRO_RANGE_250DPS      0
+#define ICM20948_GYRO_RANGE_500DPS      1
+#define ICM20948_GYRO_RANGE_1000DPS     2
+#define ICM20948_GYRO_RANGE_2000DPS     3
+
+/** @} */
+
+/**
+ * @defgroup ICM20948_ACCEL_RANGE ICM20948 Accelerometer Full Scale Range
+ * @brief Values for `icm20948_config.accel_range`.
+ *
+ * - `ICM20948_ACCEL_RANGE_2G`  (0): +-2 g, 16384 LSB/g
+ * - `ICM20948_ACCEL_RANGE_4G`  (1): +-4 g, 8192 LSB/g
+ * - `ICM20948_ACCEL_RANGE_8G`  (2): +-8 g, 4096 LSB/g
+ * - `ICM20948_ACCEL_RANGE_16G` (3): +-16 g, 2048 LSB/g
+ *
+ * @{
+ */
+#define ICM20948_ACCEL_RANGE_2G         0
+#define ICM20948_ACCEL_RANGE_4G         1
+#define ICM20948_ACCEL_RANGE_8G         2
+#define ICM20948_ACCEL_RANGE_16G        3
+
+/** @} */
+
+/**
+ * @defgroup ICM20948_DLPF ICM20948 Digital Low Pass Filter
+ * @brief Values for `icm20948_config.gyro_dlpf` and `icm20948_config.accel_dlpf` (3 dB bandwidth gyroscope / accelerometer).
+ *
+ * - `ICM20948_DLPF_0`   (0): 196.6 Hz / 246.0 Hz
+ * - `ICM20948_DLPF_1`   (1): 151.8 Hz / 246.0 Hz
+ * - `ICM20948_DLPF_2`   (2): 119.5 Hz / 111.4 Hz
+ * - `ICM20948_DLPF_3`   (3): 51.2 Hz / 50.4 Hz
+ * - `ICM20948_DLPF_4`   (4): 23.9 Hz / 23.9 Hz
+ * - `ICM20948_DLPF_5`   (5): 11.6 Hz / 11.5 Hz
+ * - `ICM20948_DLPF_6`   (6): 5.7 Hz / 5.7 Hz
+ * - `ICM20948_DLPF_7`   (7): 361.4 Hz / 473.0 Hz
+ * - `ICM20948_DLPF_OFF` (0xFF): filter bypassed, 12106 Hz / 1209 Hz. The sample rate divider is ignored and the sensors run at 9 kHz / 4.5 kHz.
+ *
+ * @{
+ */
+#define ICM20948_DLPF_0                 0
+#define ICM20948_DLPF_1                 1
+#define ICM20948_DLPF_2                 2
+#define ICM20948_DLPF_3                 3
+#define ICM20948_DLPF_4                 4
+#define ICM20948_DLPF_5                 5
+#define ICM20948_DLPF_6                 6
+#define ICM20948_DLPF_7                 7
+#define ICM20948_DLPF_OFF               0xFF
+
+/** @} */
+
+/**
+ * @def ICM20948_USER_CTRL_FIFO_EN
+ * 
+ * Bit in ICM20948_REG_USER_CTRL which enables the FIFO
+ */
+#define ICM20948_USER_CTRL_FIFO_EN      (1 << 6)
+
+/**
+ * @def ICM20948_REG_FIFO_EN_2
+ * 
+ * This value is used to select which sensor data is written to the FIFO (user bank 0)
+ */
+#define ICM20948_REG_FIFO_EN_2          0x67
+
+/**
+ * @def ICM20948_FIFO_EN_2_ACCEL_GYRO
+ * 
+ * Value for ICM20948_REG_FIFO_EN_2 which writes accelerometer and gyroscope data of all axes to the FIFO
+ */
+#define ICM20948_FIFO_EN_2_ACCEL_GYRO   0x1E
+
+/**
+ * @def ICM20948_REG_FIFO_RST
+ * 
+ * This value is used to reset the FIFO (user bank 0)
+ */
+#define ICM20948_REG_FIFO_RST           0x68
+
+/**
+ * @def ICM20948_REG_FIFO_MODE
+ * 
+ * This value is used to select stream (0) or snapshot (1) mode of the FIFO (user bank 0)
+ */
+#define ICM20948_REG_FIFO_MODE          0x69
+
+/**
+ * @def ICM20948_REG_FIFO_COUNTH
+ * 
+ * This value is used to read the number of bytes in the FIFO, high byte first (user bank 0)
+ */
+#define ICM20948_REG_FIFO_COUNTH        0x70
+
+/**
+ * @def ICM20948_REG_FIFO_R_W
+ * 
+ * This value is used to read data from the FIFO. Burst reads return consecutive FIFO bytes (user bank 0)
+ */
+#define ICM20948_REG_FIFO_R_W           0x72
+
+/**
+ * @def ICM20948_FIFO_SIZE
+ * 
+ * Size of the FIFO in bytes
  */
-#define ICM20948_AK09916_REG_MAG_ZOUT_L 0x16
+#define ICM20948_FIFO_SIZE              512
+
+/**
+ * @def ICM20948_FIFO_FRAME_LENGTH
+ * 
+ * Number of bytes of one FIFO frame: accelerometer (6) followed by gyroscope (6), big endian
+ */
+#define ICM20948_FIFO_FRAME_LENGTH      12
+
+/**
+ * @def ICM20948_REG_I2C_MST_STATUS
+ * 
+ * This value is used to read the status of the internal I2C master (user bank 0)
+ */
+#define ICM20948_REG_I2C_MST_STATUS     0x17
+
+/**
+ * @def ICM20948_I2C_MST_STATUS_SLV4_DONE
+ * 
+ * Bit in ICM20948_REG_I2C_MST_STATUS which is set when a transfer of slave 4 has finished
+ */
+#define ICM20948_I2C_MST_STATUS_SLV4_DONE (1 << 6)
+
+/**
+ * @def ICM20948_REG_EXT_SLV_SENS_DATA_00
+ * 
+ * This value is used to read the first byte the internal I2C master has read from an external sensor (user bank 0).
+ * It directly follows ICM20948_REG_TEMP_OUT_L, so it can be read in the same burst.
+ */
+#define ICM20948_REG_EXT_SLV_SENS_DATA_00 0x3B
+
+/**
+ * @def ICM20948_REG_I2C_MST_ODR_CONFIG
+ * 
+ * This value is used to set the sample rate of the internal I2C master to 1.1 kHz / 2^value (user bank 3)
+ */
+#define ICM20948_REG_I2C_MST_ODR_CONFIG 0x00
+
+/**
+ * @def ICM20948_REG_I2C_MST_CTRL
+ * 
+ * This value is used to set the clock of the internal I2C master (user bank 3)
+ */
+#define ICM20948_REG_I2C_MST_CTRL       0x01
+
+/**
+ * @def ICM20948_REG_I2C_SLV0_ADDR
+ * 
+ * This value is used to set the address of slave 0 of the internal I2C master. Bit 7 selects a read (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV0_ADDR      0x03
+
+/**
+ * @def ICM20948_REG_I2C_SLV0_REG
+ * 
+ * This value is used to set the first register read from slave 0 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV0_REG       0x04
+
+/**
+ * @def ICM20948_REG_I2C_SLV0_CTRL
+ * 
+ * This value is used to enable slave 0 and set the number of bytes read from it (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV0_CTRL      0x05
+
+/**
+ * @def ICM20948_REG_I2C_SLV1_ADDR
+ * 
+ * This value is used to set the address of slave 1 of the internal I2C master. Bit 7 selects a read (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV1_ADDR      0x07
+
+/**
+ * @def ICM20948_REG_I2C_SLV1_REG
+ * 
+ * This value is used to set the first register accessed on slave 1 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV1_REG       0x08
+
+/**
+ * @def ICM20948_REG_I2C_SLV1_CTRL
+ * 
+ * This value is used to enable slave 1 and set the number of bytes transferred (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV1_CTRL      0x09
+
+/**
+ * @def ICM20948_REG_I2C_SLV1_DO
+ * 
+ * This value is used to set the byte written to slave 1 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV1_DO        0x0A
+
+/**
+ * @def ICM20948_REG_I2C_SLV4_ADDR
+ * 
+ * This value is used to set the address of slave 4 of the internal I2C master. Bit 7 selects a read (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV4_ADDR      0x13
+
+/**
+ * @def ICM20948_REG_I2C_SLV4_REG
+ * 
+ * This value is used to set the register accessed on slave 4 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV4_REG       0x14
+
+/**
+ * @def ICM20948_REG_I2C_SLV4_CTRL
+ * 
+ * This value is used to start a single transfer with slave 4 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV4_CTRL      0x15
+
+/**
+ * @def ICM20948_REG_I2C_SLV4_DO
+ * 
+ * This value is used to set the byte written to slave 4 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV4_DO        0x16
+
+/**
+ * @def ICM20948_REG_I2C_SLV4_DI
+ * 
+ * This value is used to read the byte read from slave 4 (user bank 3)
+ */
+#define ICM20948_REG_I2C_SLV4_DI        0x17
+
+/**
+ * @def ICM20948_I2C_SLV_EN
+ * 
+ * Bit in the I2C_SLVx_CTRL registers which enables the slave
+ */
+#define ICM20948_I2C_SLV_EN             (1 << 7)
+
+/**
+ * @def ICM20948_I2C_SLV_BYTE_SW
+ * 
+ * Bit in the I2C_SLVx_CTRL registers which swaps the bytes of each word read
+ */
+#define ICM20948_I2C_SLV_BYTE_SW        (1 << 6)
+
+/**
+ * @def ICM20948_I2C_SLV_GRP
+ * 
+ * Bit in the I2C_SLVx_CTRL registers which makes words end at odd register addresses, used with ICM20948_I2C_SLV_BYTE_SW
+ */
+#define ICM20948_I2C_SLV_GRP            (1 << 4)
+
+/**
+ * @def ICM20948_I2C_SLV_READ
+ * 
+ * Bit in the I2C_SLVx_ADDR registers which selects a read transfer
+ */
+#define ICM20948_I2C_SLV_READ           (1 << 7)
 
 /**
  * @def ICM20948_REG_BANK_SEL
@@ -178,89 +725,411 @@
 /**
  * @def ICM20948_REG_XA_OFFS_H
  * 
- * This value is used to set the high byte of the accelerometer offset for the X-axis
+ * This value is used to set the high byte of the accelerometer offset for the X-axis (user bank 1)
  */
-#define ICM20948_REG_XA_OFFS_H          0x20
+#define ICM20948_REG_XA_OFFS_H          0x14
 
 /**
  * @def ICM20948_REG_XA_OFFS_L
  * 
- * This value is used to set the low byte of the accelerometer offset for the X-axis
+ * This value is used to set the low byte of the accelerometer offset for the X-axis. Bit 0 is reserved (user bank 1)
  */
-#define ICM20948_REG_XA_OFFS_L          0x21
+#define ICM20948_REG_XA_OFFS_L          0x15
 
 /**
  * @def ICM20948_REG_YA_OFFS_H
  * 
- * This value is used to set the high byte of the accelerometer offset for the Y-axis
+ * This value is used to set the high byte of the accelerometer offset for the Y-axis (user bank 1)
  */
-#define ICM20948_REG_YA_OFFS_H          0x23
+#define ICM20948_REG_YA_OFFS_H          0x17
 
 /**
  * @def ICM20948_REG_YA_OFFS_L
  * 
- * This value is used to set the low byte of the accelerometer offset for the Y-axis
+ * This value is used to set the low byte of the accelerometer offset for the Y-axis. Bit 0 is reserved (user bank 1)
  */
-#define ICM20948_REG_YA_OFFS_L          0x24
+#define ICM20948_REG_YA_OFFS_L          0x18
 
 /**
  * @def ICM20948_REG_ZA_OFFS_H
  * 
- * This value is used to set the high byte of the accelerometer offset for the Z-axis
+ * This value is used to set the high byte of the accelerometer offset for the Z-axis (user bank 1)
  */
-#define ICM20948_REG_ZA_OFFS_H          0x26
+#define ICM20948_REG_ZA_OFFS_H          0x1A
 
 /**
  * @def ICM20948_REG_ZA_OFFS_L
  * 
- * This value is used to set the low byte of the accelerometer offset for the Z-axis
+ * This value is used to set the low byte of the accelerometer offset for the Z-axis. Bit 0 is reserved (user bank 1)
  */
-#define ICM20948_REG_ZA_OFFS_L          0x27
+#define ICM20948_REG_ZA_OFFS_L          0x1B
 
 
 
 /**
  * @def ICM20948_REG_XG_OFFS_H
  * 
- * This value is used to set the high byte of the gyro offset for the X-axis
+ * This value is used to set the high byte of the gyro offset for the X-axis (user bank 2)
  */
 #define ICM20948_REG_XG_OFFS_H          0x03
 
 /**
  * @def ICM20948_REG_XG_OFFS_L
  * 
- * This value is used to set the low byte of the gyro offset for the X-axis
+ * This value is used to set the low byte of the gyro offset for the X-axis (user bank 2)
  */
 #define ICM20948_REG_XG_OFFS_L          0x04
 
 /**
  * @def ICM20948_REG_YG_OFFS_H
  * 
- * This value is used to set the high byte of the gyro offset for the Y-axis
+ * This value is used to set the high byte of the gyro offset for the Y-axis (user bank 2)
  */
 #define ICM20948_REG_YG_OFFS_H          0x05
 
 /**
  * @def ICM20948_REG_YG_OFFS_L
  * 
- * This value is used to set the low byte of the gyro offset for the Y-axis
+ * This value is used to set the low byte of the gyro offset for the Y-axis (user bank 2)
  */
 #define ICM20948_REG_YG_OFFS_L          0x06
 
 /**
  * @def ICM20948_REG_ZG_OFFS_H
  * 
- * This value is used to set the high byte of the gyro offset for the Z-axis
+ * This value is used to set the high byte of the gyro offset for the Z-axis (user bank 2)
  */
 #define ICM20948_REG_ZG_OFFS_H          0x07
 
 /**
  * @def ICM20948_REG_ZG_OFFS_L
  * 
- * This value is used to set the low byte of the gyro offset for the Z-axis
+ * This value is used to set the low byte of the gyro offset for the Z-axis (user bank 2)
  */
 #define ICM20948_REG_ZG_OFFS_L          0x08
 
+/**
+ * @def ICM20948_REG_INT_STATUS_1
+ * 
+ * This value is used to check if new sensor data is ready. Bit 0 is set by new data and cleared by reading (user bank 0)
+ */
+#define ICM20948_REG_INT_STATUS_1       0x1A
+
+/**
+ * @def ICM20948_CALIBRATION_MAGIC
+ *
+ * Marks a valid struct icm20948_calibration, e.g. in an EEPROM that was never written.
+ */
+#define ICM20948_CALIBRATION_MAGIC      0x2094
+
+/**
+ * @def ICM20948_SAMPLE_LENGTH
+ *
+ * Number of bytes from ICM20948_REG_ACCEL_XOUT_H up to and including ICM20948_REG_TEMP_OUT_L.
+ * These registers are read in a single burst by `icm20948_read_sample`.
+ */
+#define ICM20948_SAMPLE_LENGTH          14
+
+/**
+ * @def ICM20948_SAMPLE_9AXIS_LENGTH
+ *
+ * Number of bytes from ICM20948_REG_ACCEL_XOUT_H up to the last magnetometer byte in EXT_SLV_SENS_DATA.
+ * These registers are read in a single burst by `icm20948_read_sample_9axis`.
+ */
+#define ICM20948_SAMPLE_9AXIS_LENGTH    20
+
+
+
+/**
+ * @brief Configuration of the accelerometer and gyroscope used by `icm20948_configure`.
+ *
+ * With the low pass filter enabled both sensors run at 1125 Hz / (1 + divider).
+ */
+struct icm20948_config
+{
+    uint8_t gyro_range;         /**< Full scale range of the gyroscope, see ICM20948_GYRO_RANGE */
+    uint8_t gyro_dlpf;          /**< Low pass filter of the gyroscope, see ICM20948_DLPF */
+    uint8_t gyro_divider;       /**< Sample rate divider of the gyroscope (0-255) */
+    uint8_t accel_range;        /**< Full scale range of the accelerometer, see ICM20948_ACCEL_RANGE */
+    uint8_t accel_dlpf;         /**< Low pass filter of the accelerometer, see ICM20948_DLPF */
+    uint16_t accel_divider;     /**< Sample rate divider of the accelerometer (0-4095) */
+};
+
+/**
+ * @brief Wake up and configure the ICM20948.
+ * This function wakes the device from sleep, leaves the low power and duty-cycled modes, enables all axes and sets the sample
+ * rate dividers, full scale ranges and low pass filters. The output data rates of all sensors are aligned.
+ *
+ * @param[in] config The configuration to apply.
+ * @note This function has to be called before any data is read, the ICM20948 sleeps after power up.
+ */
+void icm20948_configure(const struct icm20948_config *config);
+
+/**
+ * @brief Get the output data rate of the gyroscope for a configuration.
+ *
+ * @param[in] config The configuration.
+ * @return The output data rate in mHz, e.g. 1125000 for a divider of 0.
+ */
+uint32_t icm20948_get_gyro_odr_millihertz(const struct icm20948_config *config);
+
+/**
+ * @brief Get the output data rate of the accelerometer for a configuration.
+ *
+ * @param[in] config The configuration.
+ * @return The output data rate in mHz, e.g. 1125000 for a divider of 0.
+ */
+uint32_t icm20948_get_accel_odr_millihertz(const struct icm20948_config *config);
+
+/**
+ * @brief Get the group delay of the gyroscope low pass filter for a configuration.
+ * The datasheet only specifies the 3 dB bandwidth, so the delay is estimated as 1 / (2 * pi * bandwidth).
+ *
+ * @param[in] config The configuration.
+ * @return The group delay in us.
+ */
+uint16_t icm20948_get_gyro_group_delay_us(const struct icm20948_config *config);
+
+/**
+ * @brief Get the group delay of the accelerometer low pass filter for a configuration.
+ * The datasheet only specifies the 3 dB bandwidth, so the delay is estimated as 1 / (2 * pi * bandwidth).
+ *
+ * @param[in] config The configuration.
+ * @return The group delay in us.
+ */
+uint16_t icm20948_get_accel_group_delay_us(const struct icm20948_config *config);
+
+/**
+ * @brief Switch to accelerometer-only operation with a duty-cycled accelerometer.
+ * The gyroscope is turned off and the accelerometer only wakes up for each sample, which reduces the current
+ * from about 3 mA to well below 100 uA at low rates. Leave with `icm20948_configure`.
+ *
+ * @param[in] accel_divider The accelerometer samples at 1125 Hz / (1 + accel_divider) (0-4095).
+ */
+void icm20948_accel_duty_cycle_start(uint16_t accel_divider);
+
+/**
+ * @brief Start wake-on-motion: the INT pin becomes active (low) when the acceleration changes by more than the threshold
+ * between two samples. The accelerometer is duty-cycled with `icm20948_accel_duty_cycle_start` in the meantime.
+ * The MCU can sleep until ICM20948_INTERRUPT wakes it, then call `icm20948_motion_detected`.
+ *
+ * @param[in] threshold_mg Change of the acceleration in mg on any axis that counts as motion (4 - 1020).
+ * @param[in] accel_divider The accelerometer samples at 1125 Hz / (1 + accel_divider) (0-4095).
+ */
+void icm20948_wake_on_motion_start(uint16_t threshold_mg, uint16_t accel_divider);
+
+/**
+ * @brief Stop wake-on-motion and leave the duty-cycled operation.
+ * The accelerometer samples continuously and the gyroscope is turned on again. Call `icm20948_configure` to restore the
+ * sample rate dividers of the configuration.
+ */
+void icm20948_wake_on_motion_stop();
+
+/**
+ * @brief Check for motion and rearm the INT pin.
+ * With ICM20948_INTERRUPT the I2C bus is only used after an interrupt occurred.
+ *
+ * @return 1 if motion was detected since the last call, 0 otherwise.
+ */
+uint8_t icm20948_motion_detected();
+
+/**
+ * @brief Contents of the hardware offset registers, which are lost at power down.
+ */
+struct icm20948_calibration
+{
+    uint16_t magic;             /**< ICM20948_CALIBRATION_MAGIC if valid */
+    int16_t gyro_offset[3];     /**< ICM20948_REG_XG_OFFS_H - ICM20948_REG_ZG_OFFS_L, 0.0305 dps per LSB */
+    int16_t accel_offset[3];    /**< ICM20948_REG_XA_OFFS_H - ICM20948_REG_ZA_OFFS_L, 0.98 mg per 2 LSB, bit 0 reserved */
+};
+
+/**
+ * @brief Measure the bias of the gyroscope and accelerometer and correct it in the hardware offset registers.
+ * Afterwards the sensor outputs corrected data, so no correction per sample is needed.
+ * The module has to lie still and flat with the z-axis pointing up (+1 g) during the measurement: 1 g is subtracted from z,
+ * other orientations are not supported and give a wrong accelerometer offset.
+ * The offsets already in the registers (e.g. the factory values of the accelerometer) are taken into account,
+ * so calling this again refines the calibration.
+ *
+ * @param[in] config The configuration set with `icm20948_configure`.
+ * @param[in] samples Number of samples to average, e.g. 256. This takes samples / output data rate. 0 is treated as 1.
+ * @param[out] calibration The new contents of the offset registers, to be saved with `icm20948_save_calibration`.
+ * @return 1 on success, 0 if no new data arrived within two sample periods (e.g. sensor asleep or not answering).
+ *         Then nothing is written to the offset registers and the calibration must not be saved.
+ */
+uint8_t icm20948_calibrate(const struct icm20948_config *config, uint16_t samples, struct icm20948_calibration *calibration);
+
+/**
+ * @brief Write a calibration to the hardware offset registers.
+ *
+ * @param[in] calibration The calibration.
+ */
+void icm20948_apply_calibration(const struct icm20948_calibration *calibration);
+
+/**
+ * @brief Save a calibration to the EEPROM. Only changed bytes are written.
+ *
+ * @param[in] calibration The calibration.
+ * @param[in] eeprom Address in the EEPROM, e.g. of a variable declared with EEMEM.
+ */
+void icm20948_save_calibration(const struct icm20948_calibration *calibration, struct icm20948_calibration *eeprom);
+
+/**
+ * @brief Load a calibration from the EEPROM and write it to the hardware offset registers.
+ * Call this at boot after `icm20948_configure`.
+ *
+ * @param[in] eeprom Address in the EEPROM the calibration was saved to.
+ * @return 1 if a calibration was found and applied, 0 if the EEPROM holds none.
+ */
+uint8_t icm20948_load_calibration(const struct icm20948_calibration *eeprom);
+
+/**
+ * @brief Select a user bank.
+ * ICM20948_REG_BANK_SEL is only written if the bank differs from the bank selected last.
+ *
+ * @param[in] bank The user bank to select (ICM20948_BANK_0 - ICM20948_BANK_3).
+ * @note The register access functions below select the bank on their own.
+ */
+void icm20948_select_bank(uint8_t bank);
+
+/**
+ * @brief Forget the selected user bank.
+ * The next register access writes ICM20948_REG_BANK_SEL in any case.
+ * Call this if the bank may have been changed without this driver, e.g. by a reset of the ICM20948.
+ */
+void icm20948_invalidate_bank();
+
+/**
+ * @brief Read consecutive registers in a single transaction.
+ *
+ * @param[in] bank The user bank of the registers.
+ * @param[in] register_address The first register to read.
+ * @param[out] data Buffer the register values are stored in.
+ * @param[in] length Number of registers to read (at least 1).
+ */
+void icm20948_read_registers(uint8_t bank, uint8_t register_address, uint8_t data[], uint8_t length);
+
+/**
+ * @brief Read a single register.
+ *
+ * @param[in] bank The user bank of the register.
+ * @param[in] register_address The register to read.
+ * @return The value of the register.
+ */
+uint8_t icm20948_read_register(uint8_t bank, uint8_t register_address);
+
+/**
+ * @brief Write consecutive registers in a single transaction.
+ *
+ * @param[in] bank The user bank of the registers.
+ * @param[in] register_address The first register to write.
+ * @param[in] data The values to write.
+ * @param[in] length Number of registers to write.
+ */
+void icm20948_write_registers(uint8_t bank, uint8_t register_address, const uint8_t data[], uint8_t length);
+
+/**
+ * @brief Write a single register.
+ *
+ * @param[in] bank The user bank of the register.
+ * @param[in] register_address The register to write.
+ * @param[in] value The value to write.
+ */
+void icm20948_write_register(uint8_t bank, uint8_t register_address, uint8_t value);
+
+/**
+ * @brief Change some bits of a single register without touching the others.
+ *
+ * @param[in] bank The user bank of the register.
+ * @param[in] register_address The register to change.
+ * @param[in] mask The bits to change.
+ * @param[in] value The new value of the masked bits.
+ */
+void icm20948_modify_register(uint8_t bank, uint8_t register_address, uint8_t mask, uint8_t value);
+
+/**
+ * @brief Read accelerometer, gyroscope and temperature data in one burst.
+ * This function reads ICM20948_REG_ACCEL_XOUT_H to ICM20948_REG_TEMP_OUT_L (14 bytes) in a single I2C transaction.
+ * Compared to calling the seven single-value functions this needs about a quarter of the bus time and all values are taken from the same sample.
+ *
+ * @param[out] sample The structure the signed raw values are stored in.
+ */
+void icm20948_read_sample(struct icm20948_sample *sample);
+
+/**
+ * @brief Read accelerometer, gyroscope, temperature and magnetometer data in one burst.
+ * This function reads the same registers as `icm20948_read_sample` plus the magnetometer data the internal I2C master has copied to EXT_SLV_SENS_DATA (20 bytes) in a single I2C transaction.
+ *
+ * @param[out] sample The structure the signed raw values are stored in.
+ * @note `icm20948_magnetometer_start` must be called once before, otherwise the magnetometer values are 0.
+ */
+void icm20948_read_sample_9axis(struct icm20948_sample *sample);
+
+/**
+ * @brief Start the magnetometer.
+ * This function configures the internal I2C master of the ICM20948 to set the AK09916 to continuous measurement (100 Hz)
+ * and to copy its data to the EXT_SLV_SENS_DATA registers automatically (I2C_SLV0).
+ * The host therefore never talks to the AK09916 directly and bypass mode is not needed.
+ *
+ * @return 1 if the AK09916 was found, 0 otherwise.
+ * @note `icm20948_configure` has to be called before and bypass mode has to be disabled (default after reset).
+ */
+uint8_t icm20948_magnetometer_start();
+
+/**
+ * @brief Start writing accelerometer and gyroscope data to the FIFO.
+ * The FIFO is reset and used in stream mode. Every sample creates a frame of ICM20948_FIFO_FRAME_LENGTH bytes.
+ *
+ * @param[in] watermark Number of frames at which `icm20948_fifo_watermark_reached` reports that the FIFO should be drained.
+ * @note At 1.125 kHz the FIFO holds about 37 ms of data. Drain it well before it is full.
+ * @note The watermark is only a software compare with FIFO_COUNT. No FIFO watermark interrupt is configured
+ *       (FIFO_CFG, INT_ENABLE_2 and INT_ENABLE_3 are left at their reset values), so the FIFO has to be polled.
+ */
+void icm20948_fifo_start(uint8_t watermark);
+
+/**
+ * @brief Stop writing data to the FIFO.
+ */
+void icm20948_fifo_stop();
+
+/**
+ * @brief Discard all data in the FIFO.
+ */
+void icm20948_fifo_reset();
+
+/**
+ * @brief Get the number of complete frames in the FIFO.
+ *
+ * @return Number of frames, ICM20948_FIFO_SIZE / ICM20948_FIFO_FRAME_LENGTH at most.
+ */
+uint8_t icm20948_fifo_frames();
+
+/**
+ * @brief Check if the FIFO holds at least as many frames as set by `icm20948_fifo_start`.
+ * This reads FIFO_COUNT over I2C on every call, the ICM20948 does not signal the watermark.
+ *
+ * @return 1 if the watermark is reached, 0 otherwise.
+ */
+uint8_t icm20948_fifo_watermark_reached();
+
+/**
+ * @brief Read frames from the FIFO.
+ * This function reads FIFO_COUNT and then drains as many whole frames as possible in a single burst.
+ * If the FIFO was full, the oldest data has been overwritten and the frame boundaries are lost.
+ * In that case the FIFO is reset to resynchronise, nothing is returned and `icm20948_fifo_overflowed` reports the overflow.
+ *
+ * @param[out] samples Array the samples are stored in. The temperature and magnetometer values are set to 0, they are not in the FIFO.
+ * @param[in] max Maximum number of samples to read (size of samples).
+ * @return Number of samples read.
+ */
+uint8_t icm20948_fifo_read(struct icm20948_sample samples[], uint8_t max);
+
+/**
+ * @brief Check if the FIFO overflowed since the last call.
+ *
+ * @return 1 if `icm20948_fifo_read` had to discard data, 0 otherwise.
+ */
+uint8_t icm20948_fifo_overflowed();
 
 /**
  * @brief Get the raw x-axis acceleration value from the accelerometer sensor.
@@ -313,6 +1182,7 @@ uint16_t icm20948_get_gyro_z_raw();
  * @brief Get the raw x-axis magnetometer value from the magnetometer sensor.
  *
  * @return The raw x-axis magnetometer value as a 16-bit unsigned integer.
+ * @note `icm20948_magnetometer_start` must be called once before.
  */
 uint16_t icm20948_get_magnetometer_x_raw();
 
@@ -320,6 +1190,7 @@ uint16_t icm20948_get_magnetometer_x_raw();
  * @brief Get the raw y-axis magnetometer value from the magnetometer sensor.
  *
  * @return The raw y-axis magnetometer value as a 16-bit unsigned integer.
+ * @note `icm20948_magnetometer_start` must be called once before.
  */
 uint16_t icm20948_get_magnetometer_y_raw();
 
@@ -327,6 +1198,7 @@ uint16_t icm20948_get_magnetometer_y_raw();
  * @brief Get the raw z-axis magnetometer value from the magnetometer sensor.
  *
  * @return The raw z-axis magnetometer value as a 16-bit unsigned integer.
+ * @note `icm20948_magnetometer_start` must be called once before.
  */
 uint16_t icm20948_get_magnetometer_z_raw();
 
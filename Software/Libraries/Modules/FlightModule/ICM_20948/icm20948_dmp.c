@@ -0,0 +1,331 @@
+/*
+ * icm20948_dmp.c
+ *
+ * Created: 19.10.2026 14:05:03
+ */
+
+#include "icm20948_dmp.h"
+#include <util/delay.h>
+#include <avr/pgmspace.h>
+
+// Number of data bytes for the header bits 15 (ICM20948_DMP_HEADER_ACCEL) down to 4 (ICM20948_DMP_HEADER_STEP_DETECTOR)
+static const uint8_t icm20948_dmp_data_length[12] PROGMEM = {6, 12, 6, 8, 12, 14, 6, 14, 6, 12, 12, 4};
+
+// Accelerometer gain, ACCEL_ALPHA_VAR and ACCEL_A_VAR for the accelerometer rates supported by the firmware, as in the InvenSense driver
+static const uint8_t icm20948_dmp_accel_dividers[3] = {4, 9, 19};
+static const uint32_t icm20948_dmp_accel_gains[3][3] PROGMEM = {
+    {15252014, 1026019965, 47721859},   // 225 Hz
+    {30504029, 977872018, 95869806},    // 112.5 Hz
+    {61117001, 882002213, 191739611}    // 56.25 Hz
+};
+
+// Header of a packet whose data was not complete in the FIFO yet, 0 if none
+static uint16_t icm20948_dmp_header = 0;
+
+/**
+ * @brief Select the DMP memory address for the next access of ICM20948_REG_MEM_R_W.
+ *
+ * @param[in] address Address in the DMP memory.
+ */
+static void icm20948_dmp_set_address(uint16_t address)
+{
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_MEM_BANK_SEL, address >> 8);
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_MEM_START_ADDR, address & 0xFF);
+}
+
+void icm20948_dmp_write_memory(uint16_t address, const uint8_t data[], uint8_t length)
+{
+    icm20948_dmp_set_address(address);
+    icm20948_write_registers(ICM20948_BANK_0, ICM20948_REG_MEM_R_W, data, length);
+}
+
+void icm20948_dmp_read_memory(uint16_t address, uint8_t data[], uint8_t length)
+{
+    icm20948_dmp_set_address(address);
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_MEM_R_W, data, length);
+}
+
+/**
+ * @brief Write a 16 bit value to the DMP memory.
+ *
+ * @param[in] address Address in the DMP memory.
+ * @param[in] value The value, stored high byte first.
+ */
+static void icm20948_dmp_write_word(uint16_t address, uint16_t value)
+{
+    uint8_t data[2] = {value >> 8, value & 0xFF};
+
+    icm20948_dmp_write_memory(address, data, 2);
+}
+
+/**
+ * @brief Write a 32 bit value to the DMP memory.
+ *
+ * @param[in] address Address in the DMP memory.
+ * @param[in] value The value, stored high byte first.
+ */
+static void icm20948_dmp_write_long(uint16_t address, uint32_t value)
+{
+    uint8_t data[4] = {value >> 24, (value >> 16) & 0xFF, (value >> 8) & 0xFF, value & 0xFF};
+
+    icm20948_dmp_write_memory(address, data, 4);
+}
+
+uint8_t icm20948_dmp_load(const uint8_t *image, uint16_t size)
+{
+    uint8_t chunk[ICM20948_DMP_CHUNK_SIZE];
+    uint8_t verify[ICM20948_DMP_CHUNK_SIZE];
+    uint16_t address = ICM20948_DMP_LOAD_START;
+    uint8_t start[2] = {ICM20948_DMP_PROGRAM_START >> 8, ICM20948_DMP_PROGRAM_START & 0xFF};
+
+    // The DMP may not run while its memory is written
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_DMP_EN, 0x00);
+
+    while (size)
+    {
+        // Chunks may not cross a bank of the DMP memory
+        uint16_t length = 256 - (address & 0xFF);
+        if (length > ICM20948_DMP_CHUNK_SIZE)
+        {
+            length = ICM20948_DMP_CHUNK_SIZE;
+        }
+        if (length > size)
+        {
+            length = size;
+        }
+
+        memcpy_P(chunk, image, length);
+        icm20948_dmp_write_memory(address, chunk, length);
+        icm20948_dmp_read_memory(address, verify, length);
+        for (uint8_t i = 0; i < length; i++)
+        {
+            if (verify[i] != chunk[i])
+            {
+                return 0;
+            }
+        }
+
+        image += length;
+        address += length;
+        size -= length;
+    }
+
+    icm20948_write_registers(ICM20948_BANK_2, ICM20948_REG_PRGM_START_ADDRH, start, 2);
+    return 1;
+}
+
+uint8_t icm20948_dmp_configure(const struct icm20948_config *config, uint16_t outputs, uint16_t divider)
+{
+    uint16_t ready = ICM20948_DMP_DATA_READY_GYRO | ICM20948_DMP_DATA_READY_ACCEL;
+    uint16_t motion = ICM20948_DMP_MOTION_ACCEL_CALIBR | ICM20948_DMP_MOTION_GYRO_CALIBR;
+    uint8_t pll = icm20948_read_register(ICM20948_BANK_1, ICM20948_REG_TIMEBASE_CORRECTION_PLL);
+    uint64_t gyro_scale;
+
+    if (outputs & ICM20948_DMP_HEADER_QUAT9)
+    {
+        uint8_t rate = 0;
+        while (rate < 3 && icm20948_dmp_accel_dividers[rate] != config->accel_divider)
+        {
+            rate++;
+        }
+        if (rate == 3 || !icm20948_magnetometer_start())
+        {
+            return 0;
+        }
+
+        // The DMP triggers single measurements through slave 1 and reads them through slave 0 at 1.1 kHz / 2^4 = 68.75 Hz.
+        // The AK09916 has to pass through power down between continuous and single measurement mode.
+        uint8_t trigger[3] = {ICM20948_AK09916_I2C_ADDRESS, ICM20948_AK09916_REG_CNTL2, ICM20948_AK09916_MODE_POWER_DOWN};
+        uint8_t slave[3] = {ICM20948_AK09916_I2C_ADDRESS | ICM20948_I2C_SLV_READ, ICM20948_AK09916_REG_RSV2,
+                            ICM20948_I2C_SLV_EN | ICM20948_I2C_SLV_BYTE_SW | ICM20948_I2C_SLV_GRP | ICM20948_DMP_COMPASS_READ_LENGTH};
+
+        icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_MST_ODR_CONFIG, 0x04);
+        icm20948_write_registers(ICM20948_BANK_3, ICM20948_REG_I2C_SLV1_ADDR, trigger, 2);
+        icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV1_DO, trigger[2]);
+        icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV1_CTRL, ICM20948_I2C_SLV_EN | 1);
+        _delay_ms(20);
+        icm20948_write_register(ICM20948_BANK_3, ICM20948_REG_I2C_SLV1_DO, ICM20948_AK09916_MODE_SINGLE);
+        icm20948_write_registers(ICM20948_BANK_3, ICM20948_REG_I2C_SLV0_ADDR, slave, 3);
+
+        // Compass axes to the axes of the gyroscope and accelerometer: x stays, y and z are inverted.
+        // 0x09999999 and 0xF6666667 are +-0.15 uT per LSB of the AK09916 in Q30.
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_00, 0x09999999);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_01, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_02, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_10, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_11, 0xF6666667);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_12, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_20, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_21, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_CPASS_MTX_22, 0xF6666667);
+
+        // The body frame is the sensor frame: identity in Q30
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_00, 0x40000000);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_01, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_02, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_10, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_11, 0x40000000);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_12, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_20, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_21, 0);
+        icm20948_dmp_write_long(ICM20948_DMP_B2S_MTX_22, 0x40000000);
+
+        icm20948_dmp_write_long(ICM20948_DMP_ACCEL_ONLY_GAIN, pgm_read_dword(&icm20948_dmp_accel_gains[rate][0]));
+        icm20948_dmp_write_long(ICM20948_DMP_ACCEL_ALPHA_VAR, pgm_read_dword(&icm20948_dmp_accel_gains[rate][1]));
+        icm20948_dmp_write_long(ICM20948_DMP_ACCEL_A_VAR, pgm_read_dword(&icm20948_dmp_accel_gains[rate][2]));
+        icm20948_dmp_write_word(ICM20948_DMP_ACCEL_CAL_RATE, 0);
+        icm20948_dmp_write_word(ICM20948_DMP_CPASS_TIME_BUFFER, 69);
+
+        ready |= ICM20948_DMP_DATA_READY_COMPASS;
+        motion |= ICM20948_DMP_MOTION_COMPASS_CALIBR | ICM20948_DMP_MOTION_9AXIS;
+    }
+
+    // Scales for +-4 g and +-2000 dps, the only ranges the firmware supports
+    icm20948_dmp_write_long(ICM20948_DMP_ACC_SCALE, 0x04000000);
+    icm20948_dmp_write_long(ICM20948_DMP_ACC_SCALE2, 0x00040000);
+    icm20948_dmp_write_long(ICM20948_DMP_GYRO_FULLSCALE, 0x10000000);
+
+    // Gyroscope scale factor for the sample rate, corrected by the deviation of the internal clock.
+    // As inv_icm20948_set_gyro_sf of the InvenSense driver: 264446880937391 / 10^5 * 2^gyro_level * (1 + divider) / (1270 +- pll),
+    // with gyro_level 4 for every full scale range, and saturated to 0x7FFFFFFF.
+    gyro_scale = 264446880937391ULL * 16 * (1 + config->gyro_divider);
+    if (pll & 0x80)
+    {
+        gyro_scale /= 1270 - (pll & 0x7F);
+    }
+    else
+    {
+        gyro_scale /= 1270 + pll;
+    }
+    gyro_scale /= 100000;
+    icm20948_dmp_write_long(ICM20948_DMP_GYRO_SF, (gyro_scale > 0x7FFFFFFF) ? 0x7FFFFFFF : (uint32_t)gyro_scale);
+
+    icm20948_dmp_write_word(ICM20948_DMP_ODR_QUAT6, divider);
+    icm20948_dmp_write_word(ICM20948_DMP_ODR_QUAT9, divider);
+    icm20948_dmp_write_word(ICM20948_DMP_DATA_OUT_CTL1, outputs);
+    icm20948_dmp_write_word(ICM20948_DMP_DATA_OUT_CTL2, 0x0000);
+    icm20948_dmp_write_word(ICM20948_DMP_DATA_INTR_CTL, outputs);
+    icm20948_dmp_write_word(ICM20948_DMP_MOTION_EVENT_CTL, motion);
+    icm20948_dmp_write_word(ICM20948_DMP_DATA_RDY_STATUS, ready);
+    return 1;
+}
+
+void icm20948_dmp_start()
+{
+    // Only the DMP writes to the FIFO
+    icm20948_write_register(ICM20948_BANK_0, ICM20948_REG_FIFO_EN_2, 0x00);
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_DMP_EN | ICM20948_USER_CTRL_FIFO_EN, 0x00);
+    icm20948_fifo_reset();
+    icm20948_dmp_header = 0;
+
+    // DMP_RST clears itself
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_DMP_RST, ICM20948_USER_CTRL_DMP_RST);
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_DMP_EN | ICM20948_USER_CTRL_FIFO_EN,
+                             ICM20948_USER_CTRL_DMP_EN | ICM20948_USER_CTRL_FIFO_EN);
+}
+
+void icm20948_dmp_stop()
+{
+    icm20948_modify_register(ICM20948_BANK_0, ICM20948_REG_USER_CTRL, ICM20948_USER_CTRL_DMP_EN | ICM20948_USER_CTRL_FIFO_EN, 0x00);
+}
+
+/**
+ * @brief Convert 4 big endian bytes of a DMP packet.
+ *
+ * @param[in] data The bytes.
+ * @return The value.
+ */
+static int32_t icm20948_dmp_long(const uint8_t data[])
+{
+    return (int32_t)(((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint16_t)data[2] << 8) | data[3]);
+}
+
+uint8_t icm20948_dmp_read(struct icm20948_dmp_packet *packet)
+{
+    uint8_t data[ICM20948_DMP_MAX_PACKET_LENGTH];
+    uint8_t *section = data;
+    uint16_t count;
+    uint16_t length = ICM20948_DMP_FOOTER_LENGTH;
+
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_FIFO_COUNTH, data, 2);
+    count = ((data[0] & 0x1F) << 8) | data[1];
+
+    // Data was lost, the next packet start is unknown
+    if (count >= ICM20948_FIFO_SIZE)
+    {
+        icm20948_fifo_reset();
+        icm20948_dmp_header = 0;
+        return 0;
+    }
+
+    if (!icm20948_dmp_header)
+    {
+        if (count < 2)
+        {
+            return 0;
+        }
+        icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_FIFO_R_W, data, 2);
+        count -= 2;
+        icm20948_dmp_header = (data[0] << 8) | data[1];
+
+        // Out of sync or a header this parser does not know
+        if (icm20948_dmp_header == 0 || (icm20948_dmp_header & 0x000F))
+        {
+            icm20948_fifo_reset();
+            icm20948_dmp_header = 0;
+            return 0;
+        }
+    }
+
+    for (uint8_t bit = 0; bit < 12; bit++)
+    {
+        if (icm20948_dmp_header & (0x8000 >> bit))
+        {
+            length += pgm_read_byte(&icm20948_dmp_data_length[bit]);
+        }
+    }
+
+    // More outputs than the buffer holds
+    if (length > ICM20948_DMP_MAX_PACKET_LENGTH)
+    {
+        icm20948_fifo_reset();
+        icm20948_dmp_header = 0;
+        return 0;
+    }
+    if (count < length)
+    {
+        return 0;
+    }
+
+    // Data and footer in one burst
+    icm20948_read_registers(ICM20948_BANK_0, ICM20948_REG_FIFO_R_W, data, length);
+
+    packet->header = icm20948_dmp_header;
+    for (uint8_t bit = 0; bit < 12; bit++)
+    {
+        uint16_t mask = 0x8000 >> bit;
+
+        if (icm20948_dmp_header & mask)
+        {
+            if (mask == ICM20948_DMP_HEADER_QUAT6)
+            {
+                for (uint8_t axis = 0; axis < 3; axis++)
+                {
+                    packet->quat6[axis] = icm20948_dmp_long(&section[4*axis]);
+                }
+            }
+            else if (mask == ICM20948_DMP_HEADER_QUAT9)
+            {
+                for (uint8_t axis = 0; axis < 3; axis++)
+                {
+                    packet->quat9[axis] = icm20948_dmp_long(&section[4*axis]);
+                }
+                packet->quat9_accuracy = (section[12] << 8) | section[13];
+            }
+            section += pgm_read_byte(&icm20948_dmp_data_length[bit]);
+        }
+    }
+
+    icm20948_dmp_header = 0;
+    return 1;
+}
@@ -0,0 +1,280 @@
+/*
+ * icm20948_dmp.h
+ *
+ * Digital Motion Processor (DMP) of the ICM20948. The DMP fuses the sensor data on the chip
+ * and writes quaternions to the FIFO, so the AVR only has to read one FIFO packet per sample.
+ *
+ * The DMP firmware image is not part of this library. It is distributed by TDK InvenSense
+ * with the eMD SDK (about 14 kB) and has to be placed in PROGMEM by the application,
+ * so the DMP can only be used on controllers with enough flash.
+ *
+ * Usage:
+ *     1. `icm20948_configure` with ICM20948_GYRO_RANGE_2000DPS and ICM20948_ACCEL_RANGE_4G
+ *     2. `icm20948_dmp_load` with the image
+ *     3. `icm20948_dmp_configure` and `icm20948_dmp_start`
+ *     4. `icm20948_dmp_read` in the main loop
+ *
+ * Created: 19.10.2026 14:05:12
+ */
+
+
+#ifndef ICM20948_DMP_H_
+#define ICM20948_DMP_H_
+
+#include "icm20948.h"
+
+/**
+ * @def ICM20948_REG_TIMEBASE_CORRECTION_PLL
+ * 
+ * This value is used to read the deviation of the internal clock, needed for the gyroscope scale of the DMP (user bank 1)
+ */
+#define ICM20948_REG_TIMEBASE_CORRECTION_PLL    0x28
+
+/**
+ * @def ICM20948_REG_PRGM_START_ADDRH
+ * 
+ * This value is used to set the program start address of the DMP, high byte first (user bank 2)
+ */
+#define ICM20948_REG_PRGM_START_ADDRH           0x50
+
+/**
+ * @def ICM20948_REG_MEM_START_ADDR
+ * 
+ * This value is used to set the address within the selected bank of the DMP memory (user bank 0)
+ */
+#define ICM20948_REG_MEM_START_ADDR             0x7C
+
+/**
+ * @def ICM20948_REG_MEM_R_W
+ * 
+ * This value is used to read and write the DMP memory. Burst accesses continue at the next memory address (user bank 0)
+ */
+#define ICM20948_REG_MEM_R_W                    0x7D
+
+/**
+ * @def ICM20948_REG_MEM_BANK_SEL
+ * 
+ * This value is used to select a 256 byte bank of the DMP memory (user bank 0)
+ */
+#define ICM20948_REG_MEM_BANK_SEL               0x7E
+
+/**
+ * @def ICM20948_USER_CTRL_DMP_EN
+ *
+ * Bit in ICM20948_REG_USER_CTRL which enables the DMP
+ */
+#define ICM20948_USER_CTRL_DMP_EN               (1 << 7)
+
+/**
+ * @def ICM20948_USER_CTRL_DMP_RST
+ *
+ * Bit in ICM20948_REG_USER_CTRL which resets the DMP
+ */
+#define ICM20948_USER_CTRL_DMP_RST              (1 << 3)
+
+/**
+ * @def ICM20948_DMP_LOAD_START
+ *
+ * Address in the DMP memory the image is loaded to.
+ */
+#define ICM20948_DMP_LOAD_START                 0x0090
+
+/**
+ * @def ICM20948_DMP_PROGRAM_START
+ *
+ * Address in the DMP memory the firmware starts at.
+ */
+#define ICM20948_DMP_PROGRAM_START              0x1000
+
+/**
+ * @def ICM20948_DMP_COMPASS_READ_LENGTH
+ *
+ * Number of bytes the internal I2C master reads from the AK09916 for the DMP, starting at ICM20948_AK09916_REG_RSV2:
+ * RSV2, ST1, the 6 data bytes, TMPS and ST2.
+ */
+#define ICM20948_DMP_COMPASS_READ_LENGTH        10
+
+/**
+ * @def ICM20948_DMP_CHUNK_SIZE
+ *
+ * Largest number of bytes written to the DMP memory in one transaction.
+ */
+#define ICM20948_DMP_CHUNK_SIZE                 16
+
+/**
+ * @defgroup ICM20948_DMP_MEMORY ICM20948 DMP Memory Addresses
+ * @brief Configuration values of the DMP firmware, stored big endian in the DMP memory.
+ * @{
+ */
+#define ICM20948_DMP_DATA_OUT_CTL1              (4 * 16)        /**< Outputs written to the FIFO, see ICM20948_DMP_HEADER */
+#define ICM20948_DMP_DATA_OUT_CTL2              (4 * 16 + 2)    /**< Additional outputs, not used */
+#define ICM20948_DMP_DATA_INTR_CTL              (4 * 16 + 12)   /**< Outputs which raise the DMP interrupt */
+#define ICM20948_DMP_MOTION_EVENT_CTL           (4 * 16 + 14)   /**< Calibration and fusion algorithms, see ICM20948_DMP_MOTION */
+#define ICM20948_DMP_DATA_RDY_STATUS            (8 * 16 + 10)   /**< Sensors delivering data, see ICM20948_DMP_DATA_READY */
+#define ICM20948_DMP_ODR_QUAT9                  (10 * 16 + 8)   /**< Divider of the 9-axis quaternion output */
+#define ICM20948_DMP_ODR_QUAT6                  (10 * 16 + 12)  /**< Divider of the 6-axis quaternion output */
+#define ICM20948_DMP_ACCEL_ONLY_GAIN            (16 * 16 + 12)  /**< Gain of the accelerometer in the fusion, depends on the accelerometer rate */
+#define ICM20948_DMP_GYRO_SF                    (19 * 16)       /**< Gyroscope scale factor */
+#define ICM20948_DMP_CPASS_MTX_00               (23 * 16)       /**< Compass mounting matrix, row 0 column 0, Q30 */
+#define ICM20948_DMP_CPASS_MTX_01               (23 * 16 + 4)   /**< Compass mounting matrix, row 0 column 1, Q30 */
+#define ICM20948_DMP_CPASS_MTX_02               (23 * 16 + 8)   /**< Compass mounting matrix, row 0 column 2, Q30 */
+#define ICM20948_DMP_CPASS_MTX_10               (23 * 16 + 12)  /**< Compass mounting matrix, row 1 column 0, Q30 */
+#define ICM20948_DMP_CPASS_MTX_11               (24 * 16)       /**< Compass mounting matrix, row 1 column 1, Q30 */
+#define ICM20948_DMP_CPASS_MTX_12               (24 * 16 + 4)   /**< Compass mounting matrix, row 1 column 2, Q30 */
+#define ICM20948_DMP_CPASS_MTX_20               (24 * 16 + 8)   /**< Compass mounting matrix, row 2 column 0, Q30 */
+#define ICM20948_DMP_CPASS_MTX_21               (24 * 16 + 12)  /**< Compass mounting matrix, row 2 column 1, Q30 */
+#define ICM20948_DMP_CPASS_MTX_22               (25 * 16)       /**< Compass mounting matrix, row 2 column 2, Q30 */
+#define ICM20948_DMP_ACC_SCALE                  (30 * 16)       /**< Accelerometer scale */
+#define ICM20948_DMP_FIFO_WATERMARK             (31 * 16 + 14)  /**< FIFO fill level at which the DMP interrupt is raised */
+#define ICM20948_DMP_GYRO_FULLSCALE             (72 * 16 + 12)  /**< Gyroscope full scale range */
+#define ICM20948_DMP_ACC_SCALE2                 (79 * 16 + 4)   /**< Accelerometer scale for the output */
+#define ICM20948_DMP_ACCEL_ALPHA_VAR            (91 * 16)       /**< Accelerometer low pass filter coefficient, depends on the accelerometer rate */
+#define ICM20948_DMP_ACCEL_A_VAR                (92 * 16)       /**< 2^30 - ICM20948_DMP_ACCEL_ALPHA_VAR */
+#define ICM20948_DMP_ACCEL_CAL_RATE             (94 * 16 + 4)   /**< Divider of the accelerometer calibration */
+#define ICM20948_DMP_CPASS_TIME_BUFFER          (112 * 16 + 14) /**< Compass rate in Hz */
+#define ICM20948_DMP_B2S_MTX_00                 (208 * 16)      /**< Body to sensor matrix, row 0 column 0, Q30 */
+#define ICM20948_DMP_B2S_MTX_01                 (208 * 16 + 4)  /**< Body to sensor matrix, row 0 column 1, Q30 */
+#define ICM20948_DMP_B2S_MTX_02                 (208 * 16 + 8)  /**< Body to sensor matrix, row 0 column 2, Q30 */
+#define ICM20948_DMP_B2S_MTX_10                 (208 * 16 + 12) /**< Body to sensor matrix, row 1 column 0, Q30 */
+#define ICM20948_DMP_B2S_MTX_11                 (209 * 16)      /**< Body to sensor matrix, row 1 column 1, Q30 */
+#define ICM20948_DMP_B2S_MTX_12                 (209 * 16 + 4)  /**< Body to sensor matrix, row 1 column 2, Q30 */
+#define ICM20948_DMP_B2S_MTX_20                 (209 * 16 + 8)  /**< Body to sensor matrix, row 2 column 0, Q30 */
+#define ICM20948_DMP_B2S_MTX_21                 (209 * 16 + 12) /**< Body to sensor matrix, row 2 column 1, Q30 */
+#define ICM20948_DMP_B2S_MTX_22                 (210 * 16)      /**< Body to sensor matrix, row 2 column 2, Q30 */
+/** @} */
+
+/**
+ * @defgroup ICM20948_DMP_HEADER ICM20948 DMP Packet Header
+ * @brief Bits of the header in front of every DMP packet in the FIFO, also used to select the outputs.
+ * The data of the set bits follows the header in this order (highest bit first).
+ * @{
+ */
+#define ICM20948_DMP_HEADER_ACCEL               0x8000  /**< 6 bytes */
+#define ICM20948_DMP_HEADER_GYRO                0x4000  /**< 12 bytes */
+#define ICM20948_DMP_HEADER_COMPASS             0x2000  /**< 6 bytes */
+#define ICM20948_DMP_HEADER_ALS                 0x1000  /**< 8 bytes */
+#define ICM20948_DMP_HEADER_QUAT6               0x0800  /**< 12 bytes: x, y, z of the 6-axis quaternion in Q30 */
+#define ICM20948_DMP_HEADER_QUAT9               0x0400  /**< 14 bytes: x, y, z of the 9-axis quaternion in Q30, heading accuracy */
+#define ICM20948_DMP_HEADER_PQUAT6              0x0200  /**< 6 bytes */
+#define ICM20948_DMP_HEADER_GEOMAG              0x0100  /**< 14 bytes */
+#define ICM20948_DMP_HEADER_PRESSURE            0x0080  /**< 6 bytes */
+#define ICM20948_DMP_HEADER_GYRO_CALIBR         0x0040  /**< 12 bytes */
+#define ICM20948_DMP_HEADER_COMPASS_CALIBR      0x0020  /**< 12 bytes */
+#define ICM20948_DMP_HEADER_STEP_DETECTOR       0x0010  /**< 4 bytes */
+#define ICM20948_DMP_HEADER_HEADER2             0x0008  /**< A second header follows, not supported */
+/** @} */
+
+/**
+ * @def ICM20948_DMP_FOOTER_LENGTH
+ *
+ * Number of bytes at the end of every DMP packet.
+ */
+#define ICM20948_DMP_FOOTER_LENGTH              2
+
+/**
+ * @def ICM20948_DMP_MAX_PACKET_LENGTH
+ *
+ * Size of the buffer for the data and footer of a packet, read in one burst.
+ * 48 bytes hold accelerometer, gyroscope, 6-axis and 9-axis quaternion together.
+ * Packets with more outputs are skipped by resetting the FIFO.
+ */
+#define ICM20948_DMP_MAX_PACKET_LENGTH          48
+
+/**
+ * @defgroup ICM20948_DMP_MOTION ICM20948 DMP Motion Event Control
+ * @{
+ */
+#define ICM20948_DMP_MOTION_ACCEL_CALIBR        0x0200
+#define ICM20948_DMP_MOTION_GYRO_CALIBR         0x0100
+#define ICM20948_DMP_MOTION_COMPASS_CALIBR      0x0080
+#define ICM20948_DMP_MOTION_9AXIS               0x0040
+/** @} */
+
+/**
+ * @defgroup ICM20948_DMP_DATA_READY ICM20948 DMP Data Ready Status
+ * @{
+ */
+#define ICM20948_DMP_DATA_READY_GYRO            0x0001
+#define ICM20948_DMP_DATA_READY_ACCEL           0x0002
+#define ICM20948_DMP_DATA_READY_COMPASS         0x0008
+/** @} */
+
+/**
+ * @brief Quaternions read from the FIFO.
+ * Only x, y and z are sent, w = sqrt(1 - x^2 - y^2 - z^2) is positive.
+ */
+struct icm20948_dmp_packet
+{
+    uint16_t header;            /**< Outputs contained in this packet, see ICM20948_DMP_HEADER */
+    int32_t quat6[3];           /**< 6-axis quaternion (gyroscope and accelerometer) in Q30, valid if ICM20948_DMP_HEADER_QUAT6 is set */
+    int32_t quat9[3];           /**< 9-axis quaternion (including the magnetometer) in Q30, valid if ICM20948_DMP_HEADER_QUAT9 is set */
+    uint16_t quat9_accuracy;    /**< Estimated heading accuracy of quat9 */
+};
+
+/**
+ * @brief Write to the DMP memory.
+ * The data may not cross a 256 byte bank of the DMP memory.
+ *
+ * @param[in] address Address in the DMP memory.
+ * @param[in] data The data.
+ * @param[in] length Number of bytes, up to ICM20948_DMP_CHUNK_SIZE.
+ */
+void icm20948_dmp_write_memory(uint16_t address, const uint8_t data[], uint8_t length);
+
+/**
+ * @brief Read from the DMP memory.
+ * The data may not cross a 256 byte bank of the DMP memory.
+ *
+ * @param[in] address Address in the DMP memory.
+ * @param[out] data The data.
+ * @param[in] length Number of bytes, up to ICM20948_DMP_CHUNK_SIZE.
+ */
+void icm20948_dmp_read_memory(uint16_t address, uint8_t data[], uint8_t length);
+
+/**
+ * @brief Load the DMP firmware and check it by reading it back.
+ * The ICM20948 has to be awake, e.g. after `icm20948_configure`.
+ *
+ * @param[in] image The firmware image in PROGMEM.
+ * @param[in] size Size of the image in bytes.
+ * @return 1 if the firmware was loaded correctly, 0 otherwise.
+ */
+uint8_t icm20948_dmp_load(const uint8_t *image, uint16_t size);
+
+/**
+ * @brief Select the quaternion outputs and their rate.
+ * The DMP runs at the output data rate of the gyroscope, 1125 Hz / (1 + config->gyro_divider).
+ * For ICM20948_DMP_HEADER_QUAT9 the internal I2C master is set up to let the DMP read the AK09916 at 69 Hz,
+ * `icm20948_magnetometer_start` may not be used at the same time. The firmware only has accelerometer gains
+ * for 225 Hz, 112.5 Hz and 56.25 Hz, so config->accel_divider has to be 4, 9 or 19.
+ *
+ * @param[in] config The configuration set with `icm20948_configure`.
+ * @param[in] outputs ICM20948_DMP_HEADER_QUAT6 and/or ICM20948_DMP_HEADER_QUAT9.
+ * @param[in] divider The quaternions are output at the DMP rate / (1 + divider).
+ * @return 1 if the DMP was configured, 0 if ICM20948_DMP_HEADER_QUAT9 was requested with an unsupported accelerometer rate
+ *         or the AK09916 did not respond.
+ */
+uint8_t icm20948_dmp_configure(const struct icm20948_config *config, uint16_t outputs, uint16_t divider);
+
+/**
+ * @brief Reset and start the DMP with an empty FIFO.
+ * The DMP uses the FIFO on its own, `icm20948_fifo_start` may not be used at the same time.
+ */
+void icm20948_dmp_start();
+
+/**
+ * @brief Stop the DMP.
+ */
+void icm20948_dmp_stop();
+
+/**
+ * @brief Read the next packet from the FIFO.
+ * A packet is only read when all its bytes are in the FIFO. After the FIFO count and the header,
+ * the rest of the packet is read in one burst. On an unknown header the FIFO is reset to find the start of the next packet.
+ *
+ * @param[out] packet The packet.
+ * @return 1 if a packet was read, 0 if there is no complete packet yet.
+ */
+uint8_t icm20948_dmp_read(struct icm20948_dmp_packet *packet);
+
+#endif /* ICM20948_DMP_H_ */
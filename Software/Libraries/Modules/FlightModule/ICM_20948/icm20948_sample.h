@@ -0,0 +1,30 @@
+/*
+ * icm20948_sample.h
+ *
+ * Sample structure of the ICM20948. Kept separate from icm20948.h so code which only
+ * processes samples (e.g. the AHRS) does not depend on the AVR headers.
+ *
+ * Created: 19.10.2026 11:20:04
+ */
+
+
+#ifndef ICM20948_SAMPLE_H_
+#define ICM20948_SAMPLE_H_
+
+#include <stdint.h>
+
+/**
+ * @brief One measurement of the accelerometer, gyroscope and temperature sensor.
+ *
+ * All values are raw two's complement values exactly as they are stored in the output registers.
+ * Because they are read in a single burst they always belong to the same sample.
+ */
+struct icm20948_sample
+{
+    int16_t accel[3];       /**< Raw acceleration of the x-, y- and z-axis */
+    int16_t gyro[3];        /**< Raw angular rate of the x-, y- and z-axis */
+    int16_t temperature;    /**< Raw temperature */
+    int16_t mag[3];         /**< Raw magnetic flux density of the x-, y- and z-axis (0.15 uT/LSB), only set by `icm20948_read_sample_9axis` */
+};
+
+#endif /* ICM20948_SAMPLE_H_ */
@@ -0,0 +1,230 @@
+/*
+ * test_host.c
+ *
+ * Host test for the vibration analysis. Compares the fixed-point spectrum with a
+ * double precision DFT of the same block and checks the peaks, bands and RMS of
+ * synthetic vibrations.
+ *
+ * Build and run on Linux for every block size:
+ *     gcc -O2 -I../ICM_20948 -DVIBRATION_FFT_SIZE=128 -o test_host test_host.c vibration.c -lm
+ *     ./test_host
+ *
+ * Created: 19.10.2026 13:22:40
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "vibration.h"
+
+#define N VIBRATION_FFT_SIZE
+#define RATE 1125000UL      // Accelerometer ODR with divider 0, in millihertz
+
+static int failures = 0;
+
+static void check(int condition, const char *message, double value)
+{
+    if (!condition)
+    {
+        printf("FAIL: %s (%g)\n", message, value);
+        failures++;
+    }
+}
+
+static double uniform(double low, double high)
+{
+    return low + (high - low) * rand() / (double)RAND_MAX;
+}
+
+// Fill a block through the public interface with a sum of sine waves, gravity and noise
+static void fill(struct vibration *vibration, const double *amplitude, const double *bin, int waves, double noise, double *samples)
+{
+    struct icm20948_sample sample = {{0, 0, 0}, {0, 0, 0}, 0, {0, 0, 0}};
+
+    vibration_init(vibration, 2);
+    for (int n = 0; n < N; n++)
+    {
+        double value = 8192;
+        for (int w = 0; w < waves; w++)
+        {
+            value += amplitude[w] * sin(2 * M_PI * bin[w] * n / N + w);
+        }
+        value += uniform(-noise, noise);
+        sample.accel[2] = (int16_t)lrint(value);
+        samples[n] = sample.accel[2];
+        vibration_add_samples(vibration, &sample, 1);
+    }
+}
+
+// The reference: same mean removal and window, DFT in double
+static void reference_power(const double *samples, double *power)
+{
+    double mean = 0;
+    double windowed[N];
+
+    for (int n = 0; n < N; n++)
+    {
+        mean += samples[n];
+    }
+    mean = floor(mean / N);
+    for (int n = 0; n < N; n++)
+    {
+        windowed[n] = (samples[n] - mean) * 0.5 * (1 - cos(2 * M_PI * n / N));
+    }
+    for (int k = 0; k < N / 2; k++)
+    {
+        double re = 0, im = 0;
+        for (int n = 0; n < N; n++)
+        {
+            re += windowed[n] * cos(2 * M_PI * k * n / N);
+            im -= windowed[n] * sin(2 * M_PI * k * n / N);
+        }
+        power[k] = (re * re + im * im) / ((double)N * N);
+    }
+}
+
+static double reference_rms(const double *samples)
+{
+    double mean = 0, squares = 0;
+    for (int n = 0; n < N; n++)
+    {
+        mean += samples[n];
+    }
+    mean = floor(mean / N);
+    for (int n = 0; n < N; n++)
+    {
+        squares += (samples[n] - mean) * (samples[n] - mean);
+    }
+    return sqrt(squares / N);
+}
+
+static void test_spectrum(void)
+{
+    struct vibration vibration;
+    double samples[N], power[N / 2];
+    double error_max = 0;
+
+    for (int run = 0; run < 200; run++)
+    {
+        double amplitude[3] = {uniform(10, 8000), uniform(10, 4000), uniform(10, 2000)};
+        double bin[3] = {uniform(2, N / 2 - 3), uniform(2, N / 2 - 3), uniform(2, N / 2 - 3)};
+
+        fill(&vibration, amplitude, bin, 3, 50, samples);
+        uint16_t rms = vibration_spectrum(&vibration);
+        reference_power(samples, power);
+
+        check(fabs(rms - reference_rms(samples)) <= 1, "rms", rms - reference_rms(samples));
+        for (int k = 0; k < N / 2; k++)
+        {
+            // Error of the magnitude in LSB of the accelerometer
+            double error = fabs(sqrt((double)vibration.data.power[k]) - sqrt(power[k]));
+            error_max = fmax(error_max, error);
+        }
+    }
+    printf("spectrum:  max magnitude error %.2f LSB\n", error_max);
+    check(error_max < 4, "magnitude error", error_max);
+}
+
+static void test_peaks(void)
+{
+    struct vibration vibration;
+    struct vibration_result result;
+    double samples[N];
+    double frequency_error = 0, amplitude_error = 0, energy_error = 0;
+
+    for (int run = 0; run < 500; run++)
+    {
+        double amplitude[2] = {uniform(1000, 8000), 0};
+        double bin[2];
+        double energy = 0;
+
+        amplitude[1] = amplitude[0] * uniform(0.2, 0.9);
+        bin[0] = uniform(3, N / 2 - 4);
+        do
+        {
+            bin[1] = uniform(3, N / 2 - 4);
+        }
+        while (fabs(bin[1] - bin[0]) < 6);
+
+        fill(&vibration, amplitude, bin, 2, 0.5, samples);
+        vibration_analyze(&vibration, RATE, &result);
+        check(vibration.count == 0, "new block", vibration.count);
+
+        for (int w = 0; w < 2; w++)
+        {
+            double expected = bin[w] * RATE / N;
+            double error = fabs(result.peaks[w].frequency - expected) / ((double)RATE / N);
+            frequency_error = fmax(frequency_error, error);
+            amplitude_error = fmax(amplitude_error, fabs(result.peaks[w].amplitude - amplitude[w]) / amplitude[w]);
+        }
+        for (int b = 0; b < VIBRATION_BANDS; b++)
+        {
+            energy += result.band_energy[b];
+        }
+        energy_error = fmax(energy_error, fabs(sqrt(energy * 16 / 3) - result.rms) / result.rms);
+    }
+    printf("peaks:     max frequency error %.3f bins, max amplitude error %.2f %%\n", frequency_error, amplitude_error * 100);
+    printf("bands:     max error of sqrt(16/3 energy) vs RMS %.2f %%\n", energy_error * 100);
+    check(frequency_error < 0.05, "frequency error", frequency_error);
+    check(amplitude_error < 0.03, "amplitude error", amplitude_error);
+    check(energy_error < 0.05, "band energy", energy_error);
+}
+
+static void test_saturation(void)
+{
+    struct vibration vibration;
+    struct vibration_result result;
+    double samples[N];
+    double amplitude[1] = {32000};
+    double bin[1] = {N / 8.0};
+
+    // Full scale square-like input must not overflow
+    fill(&vibration, amplitude, bin, 1, 0, samples);
+    for (int n = 0; n < N; n++)
+    {
+        vibration.data.samples[n] = (n & 4) ? 32767 : -32768;
+    }
+    vibration_analyze(&vibration, RATE, &result);
+    check(result.peaks[0].frequency > 0, "full scale peak", result.peaks[0].frequency);
+    check(result.rms == 32767 || result.rms == 32768, "full scale rms", result.rms);
+}
+
+static void benchmark(void)
+{
+    struct vibration vibration;
+    struct vibration_result result;
+    double samples[N];
+    double amplitude[1] = {1000};
+    double bin[1] = {10.3};
+    const int repeat = 20000;
+    clock_t time = 0;
+
+    for (int r = 0; r < repeat; r++)
+    {
+        fill(&vibration, amplitude, bin, 1, 5, samples);
+        clock_t start = clock();
+        vibration_analyze(&vibration, RATE, &result);
+        time += clock() - start;
+    }
+    printf("time:      %.2f us per block on the host\n", 1e6 * time / CLOCKS_PER_SEC / repeat);
+    printf("data:      %u bytes per block instead of %u bytes of raw samples\n", (unsigned)sizeof(result), (unsigned)(N * 2));
+}
+
+int main(void)
+{
+    printf("block size %d\n", N);
+    test_spectrum();
+    test_peaks();
+    test_saturation();
+    benchmark();
+
+    if (failures)
+    {
+        printf("%d checks failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*
+ * vibration.c
+ *
+ * Created: 19.10.2026 12:40:52
+ */
+
+#include "vibration.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_word(address) (*(address))
+#endif
+
+#if VIBRATION_FFT_SIZE == 64
+#define VIBRATION_FFT_LOG2 6
+#elif VIBRATION_FFT_SIZE == 128
+#define VIBRATION_FFT_LOG2 7
+#else
+#define VIBRATION_FFT_LOG2 8
+#endif
+
+/**
+ * @def VIBRATION_HALF
+ *
+ * Number of points of the complex FFT, two real samples form one complex value.
+ */
+#define VIBRATION_HALF (VIBRATION_FFT_SIZE / 2)
+
+/**
+ * @def VIBRATION_LIMIT
+ *
+ * Largest windowed sample. Larger values (more than 70 % of the full scale range away from the mean) are saturated.
+ */
+#define VIBRATION_LIMIT 23170
+
+/**
+ * @def VIBRATION_SINE_STEP
+ *
+ * Step through vibration_sine_table for one bin of VIBRATION_FFT_SIZE.
+ */
+#define VIBRATION_SINE_STEP (256 / VIBRATION_FFT_SIZE)
+
+// sin(2 * pi * k / 256) in Q15 for a quarter turn, enough for all FFT sizes
+static const int16_t vibration_sine_table[65] PROGMEM =
+{
+    0, 804, 1608, 2411, 3212, 4011, 4808, 5602,
+    6393, 7180, 7962, 8740, 9512, 10279, 11039, 11793,
+    12540, 13279, 14010, 14733, 15447, 16151, 16846, 17531,
+    18205, 18868, 19520, 20160, 20788, 21403, 22006, 22595,
+    23170, 23732, 24279, 24812, 25330, 25833, 26320, 26791,
+    27246, 27684, 28106, 28511, 28899, 29269, 29622, 29957,
+    30274, 30572, 30853, 31114, 31357, 31581, 31786, 31972,
+    32138, 32286, 32413, 32522, 32610, 32679, 32729, 32758,
+    32767
+};
+
+/**
+ * @brief sin(2 * pi * k / VIBRATION_FFT_SIZE) in Q15.
+ *
+ * @param[in] k The angle, 0 to VIBRATION_FFT_SIZE / 2.
+ * @return The sine.
+ */
+static int16_t vibration_sin(uint16_t k)
+{
+    if (k > VIBRATION_FFT_SIZE / 4)
+    {
+        k = VIBRATION_FFT_SIZE / 2 - k;
+    }
+    return pgm_read_word(&vibration_sine_table[k * VIBRATION_SINE_STEP]);
+}
+
+/**
+ * @brief cos(2 * pi * k / VIBRATION_FFT_SIZE) in Q15.
+ *
+ * @param[in] k The angle, 0 to VIBRATION_FFT_SIZE.
+ * @return The cosine.
+ */
+static int16_t vibration_cos(uint16_t k)
+{
+    if (k > VIBRATION_FFT_SIZE / 2)
+    {
+        k = VIBRATION_FFT_SIZE - k;
+    }
+    if (k <= VIBRATION_FFT_SIZE / 4)
+    {
+        return vibration_sin(VIBRATION_FFT_SIZE / 4 - k);
+    }
+    return -vibration_sin(k - VIBRATION_FFT_SIZE / 4);
+}
+
+/**
+ * @brief Multiply with a Q15 factor and round.
+ */
+static int32_t vibration_multiply(int32_t value, int16_t factor)
+{
+    return (value * factor + (1L << 14)) >> 15;
+}
+
+/**
+ * @brief Integer square root.
+ *
+ * @param[in] value The value.
+ * @return floor(sqrt(value))
+ */
+static uint16_t vibration_sqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief Complex radix-2 FFT in place, decimation in time, every stage scaled by 1/2.
+ *
+ * @param[in,out] data VIBRATION_HALF complex values, real and imaginary part alternating.
+ */
+static void vibration_fft(int16_t data[])
+{
+    // Bit reversed order
+    for (uint8_t i = 1, j = 0; i < VIBRATION_HALF; i++)
+    {
+        uint8_t bit = VIBRATION_HALF >> 1;
+        while (j & bit)
+        {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+        if (i < j)
+        {
+            int16_t swap = data[2 * i];
+            data[2 * i] = data[2 * j];
+            data[2 * j] = swap;
+            swap = data[2 * i + 1];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j + 1] = swap;
+        }
+    }
+
+    for (uint8_t size = 2; size && size <= VIBRATION_HALF; size <<= 1)
+    {
+        uint8_t half = size >> 1;
+        uint8_t step = VIBRATION_FFT_SIZE / size;
+
+        for (uint8_t j = 0; j < half; j++)
+        {
+            // Twiddle factor e^(-2 pi i j / size) = cos - i sin
+            int16_t c = vibration_cos(j * step);
+            int16_t s = vibration_sin(j * step);
+
+            for (uint8_t i = j; i < VIBRATION_HALF; i += size)
+            {
+                int16_t *top = &data[2 * i];
+                int16_t *bottom = &data[2 * (i + half)];
+                int32_t tr = vibration_multiply(bottom[0], c) + vibration_multiply(bottom[1], s);
+                int32_t ti = vibration_multiply(bottom[1], c) - vibration_multiply(bottom[0], s);
+
+                bottom[0] = (top[0] - tr) >> 1;
+                bottom[1] = (top[1] - ti) >> 1;
+                top[0] = (top[0] + tr) >> 1;
+                top[1] = (top[1] + ti) >> 1;
+            }
+        }
+    }
+}
+
+void vibration_init(struct vibration *vibration, uint8_t axis)
+{
+    vibration->count = 0;
+    vibration->axis = axis;
+}
+
+uint16_t vibration_add_samples(struct vibration *vibration, const struct icm20948_sample samples[], uint8_t count)
+{
+    for (uint8_t i = 0; i < count && vibration->count < VIBRATION_FFT_SIZE; i++)
+    {
+        vibration->data.samples[vibration->count++] = samples[i].accel[vibration->axis];
+    }
+    return vibration->count;
+}
+
+uint16_t vibration_spectrum(struct vibration *vibration)
+{
+    int16_t *data = vibration->data.samples;
+    int32_t sum = 0;
+    uint32_t squares_high = 0;
+    uint32_t squares_low = 0;
+    int16_t mean;
+
+    for (uint16_t n = 0; n < VIBRATION_FFT_SIZE; n++)
+    {
+        sum += data[n];
+    }
+    mean = sum >> VIBRATION_FFT_LOG2;
+
+    // Remove the mean, sum up the squares for the RMS and apply the Hann window
+    for (uint16_t n = 0; n < VIBRATION_FFT_SIZE; n++)
+    {
+        int32_t value = (int32_t)data[n] - mean;
+        uint32_t square = (uint32_t)((value < 0) ? -value : value);
+        uint16_t window = (32767L - vibration_cos(n)) >> 1;
+
+        square *= square;
+        squares_low += square;
+        if (squares_low < square)
+        {
+            squares_high++;
+        }
+
+        // Limited to 32768 / sqrt(2), so the complex values of the FFT stay below 32768
+        value = (value * window) >> 15;
+        data[n] = (value > VIBRATION_LIMIT) ? VIBRATION_LIMIT : ((value < -VIBRATION_LIMIT) ? -VIBRATION_LIMIT : value);
+    }
+    // Mean of the squares, the sum is below 2^40
+    squares_low = (squares_low >> VIBRATION_FFT_LOG2) | (squares_high << (32 - VIBRATION_FFT_LOG2));
+
+    vibration_fft(data);
+
+    // Split the complex FFT of half the size into the spectrum of the real samples:
+    // X[k] = (Z[k] + Z*[M - k]) / 2 - i W^k (Z[k] - Z*[M - k]) / 2 and |X[M - k]| = |(Z[k] + Z*[M - k]) / 2 + i W^k (Z[k] - Z*[M - k]) / 2|
+    {
+        int32_t dc = (int32_t)data[0] + data[1];
+        vibration->data.power[0] = (uint32_t)((dc * dc) >> 2);
+    }
+    for (uint8_t k = 1; k <= VIBRATION_HALF / 2; k++)
+    {
+        uint8_t mirror = VIBRATION_HALF - k;
+        int32_t ar = data[2 * k], ai = data[2 * k + 1];
+        int32_t br = data[2 * mirror], bi = -(int32_t)data[2 * mirror + 1];
+        int32_t er = ar + br, ei = ai + bi;
+        // -i * (A - B)
+        int32_t dr = ai - bi, di = br - ar;
+        int16_t c = vibration_cos(k);
+        int16_t s = vibration_sin(k);
+        // W^k = cos - i sin
+        int32_t wr = vibration_multiply(dr, c) + vibration_multiply(di, s);
+        int32_t wi = vibration_multiply(di, c) - vibration_multiply(dr, s);
+        // Scaled by 1/4 to |X / N|
+        int32_t xr = (er + wr) >> 2, xi = (ei + wi) >> 2;
+        int32_t yr = (er - wr) >> 2, yi = (ei - wi) >> 2;
+
+        vibration->data.power[k] = (uint32_t)(xr * xr) + (uint32_t)(xi * xi);
+        vibration->data.power[mirror] = (uint32_t)(yr * yr) + (uint32_t)(yi * yi);
+    }
+
+    return vibration_sqrt(squares_low);
+}
+
+void vibration_analyze(struct vibration *vibration, uint32_t sample_rate, struct vibration_result *result)
+{
+    const uint32_t *power = vibration->data.power;
+
+    result->rms = vibration_spectrum(vibration);
+
+    for (uint8_t band = 0; band < VIBRATION_BANDS; band++)
+    {
+        result->band_energy[band] = 0;
+    }
+    for (uint8_t peak = 0; peak < VIBRATION_PEAKS; peak++)
+    {
+        result->peaks[peak].frequency = 0;
+        result->peaks[peak].amplitude = 0;
+    }
+
+    for (uint8_t k = 1; k < VIBRATION_HALF; k++)
+    {
+        uint32_t *energy = &result->band_energy[k / (VIBRATION_HALF / VIBRATION_BANDS)];
+
+        *energy = (*energy + power[k] < *energy) ? UINT32_MAX : *energy + power[k];
+
+        if (k < VIBRATION_HALF - 1 && power[k] > power[k - 1] && power[k] >= power[k + 1])
+        {
+            // The Hann window spreads a sine wave over 3 bins, for which an exact interpolation exists
+            uint32_t a = vibration_sqrt(power[k - 1]);
+            uint32_t b = vibration_sqrt(power[k]);
+            uint32_t c = vibration_sqrt(power[k + 1]);
+            uint32_t total = a + 2 * b + c;
+            // Offset from bin k in 1/256 bins, -128 to 128
+            int32_t offset = ((int32_t)c - (int32_t)a) * 512 / (int32_t)total;
+            // A sine wave of amplitude A gives a + 2b + c = 3/4 A in the center of a bin, and 10 % less between two bins
+            uint32_t amplitude = (total * 4 + 1) / 3;
+            uint8_t slot = VIBRATION_PEAKS;
+
+            amplitude += (amplitude * (((uint32_t)(offset * offset) * 107) >> 12)) >> 12;
+            if (amplitude > UINT16_MAX)
+            {
+                amplitude = UINT16_MAX;
+            }
+
+            // Insert sorted by amplitude
+            while (slot > 0 && result->peaks[slot - 1].amplitude < amplitude)
+            {
+                if (slot < VIBRATION_PEAKS)
+                {
+                    result->peaks[slot] = result->peaks[slot - 1];
+                }
+                slot--;
+            }
+            if (slot < VIBRATION_PEAKS)
+            {
+                result->peaks[slot].amplitude = amplitude;
+                result->peaks[slot].frequency = (k * sample_rate + offset * (int32_t)(sample_rate >> 8)) >> VIBRATION_FFT_LOG2;
+            }
+        }
+    }
+
+    vibration->count = 0;
+}
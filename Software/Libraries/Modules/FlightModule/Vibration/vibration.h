@@ -0,0 +1,132 @@
+/*
+ * vibration.h
+ *
+ * Vibration analysis of accelerometer data with a fixed-point FFT.
+ * Instead of the raw samples only the strongest frequencies, the energy in frequency bands
+ * and the RMS of a block are sent. The result has 58 bytes on the AVR (68 on hosts which pad the structures),
+ * against 128, 256 or 512 bytes of raw samples of one axis for 64, 128 or 256 samples per block:
+ * about 2 to 9 times less data, growing with the block length.
+ *
+ * Usage:
+ *     1. `vibration_init` with the axis to analyze
+ *     2. Feed the samples of `icm20948_fifo_read` to `vibration_add_samples` until it returns VIBRATION_FFT_SIZE
+ *     3. `vibration_analyze` with the output data rate of `icm20948_get_accel_odr_millihertz`
+ *
+ * Created: 19.10.2026 12:41:05
+ */
+
+
+#ifndef VIBRATION_H_
+#define VIBRATION_H_
+
+#include <stdint.h>
+#include "icm20948_sample.h"
+
+/**
+ * @def VIBRATION_FFT_SIZE
+ *
+ * Number of samples in one block: 64, 128 or 256.
+ * The frequency resolution is the sample rate divided by this value.
+ * The block is the largest part of the RAM used (2 bytes per sample), 256 samples need half of the RAM of an ATmega16A.
+ * Can be set for the whole project, e.g. -DVIBRATION_FFT_SIZE=256.
+ */
+#ifndef VIBRATION_FFT_SIZE
+#define VIBRATION_FFT_SIZE 128
+#endif
+
+/**
+ * @def VIBRATION_PEAKS
+ *
+ * Number of peak frequencies reported per block.
+ */
+#define VIBRATION_PEAKS 4
+
+/**
+ * @def VIBRATION_BANDS
+ *
+ * Number of frequency bands reported per block. The bands split 0 Hz to half the sample rate into equal parts.
+ * Has to divide VIBRATION_FFT_SIZE / 2.
+ */
+#define VIBRATION_BANDS 8
+
+#if VIBRATION_FFT_SIZE != 64 && VIBRATION_FFT_SIZE != 128 && VIBRATION_FFT_SIZE != 256
+#error "VIBRATION_FFT_SIZE has to be 64, 128 or 256"
+#endif
+
+/**
+ * @brief A frequency with a local maximum in the spectrum.
+ */
+struct vibration_peak
+{
+    uint32_t frequency;     // Interpolated between the FFT bins, in millihertz
+    uint16_t amplitude;     // Amplitude of the sine wave in LSB of the accelerometer, 0 if there are less peaks
+};
+
+/**
+ * @brief Result of one block.
+ */
+struct vibration_result
+{
+    uint16_t rms;                                   // RMS without the mean (gravity) in LSB
+    struct vibration_peak peaks[VIBRATION_PEAKS];   // Strongest peaks first
+    uint32_t band_energy[VIBRATION_BANDS];          // Sum of the squared FFT bins (divided by the block length), saturated
+};
+
+/**
+ * @brief Block of samples of one axis.
+ * During `vibration_analyze` the samples are replaced by the spectrum in place, so no second buffer is needed.
+ */
+struct vibration
+{
+    union
+    {
+        int16_t samples[VIBRATION_FFT_SIZE];
+        uint32_t power[VIBRATION_FFT_SIZE / 2];     // |X[k] / N|^2 after the FFT, the bin at half the sample rate is dropped
+    } data;
+    uint16_t count;
+    uint8_t axis;
+};
+
+/**
+ * @brief Start an empty block.
+ *
+ * @param[in] vibration The block.
+ * @param[in] axis The accelerometer axis to analyze: 0 = x, 1 = y, 2 = z.
+ */
+void vibration_init(struct vibration *vibration, uint8_t axis);
+
+/**
+ * @brief Append accelerometer samples to the block.
+ * Samples that do not fit anymore are ignored, so only pass as many as VIBRATION_FFT_SIZE minus the returned value.
+ *
+ * @param[in] vibration The block.
+ * @param[in] samples The samples, e.g. read with `icm20948_fifo_read`.
+ * @param[in] count Number of samples.
+ * @return Number of samples in the block, the block is full at VIBRATION_FFT_SIZE.
+ */
+uint16_t vibration_add_samples(struct vibration *vibration, const struct icm20948_sample samples[], uint8_t count);
+
+/**
+ * @brief Compute the power spectrum of the block in place.
+ * The mean is removed, a Hann window is applied and a real FFT of VIBRATION_FFT_SIZE points is calculated
+ * as a complex FFT of half the size. Every stage is scaled by 1/2, so nothing can overflow.
+ * Samples more than 23170 LSB away from the mean are saturated.
+ * Afterwards `vibration->data.power` holds the spectrum, bin k is at k * sample rate / VIBRATION_FFT_SIZE.
+ *
+ * @param[in] vibration A full block.
+ * @return The RMS of the samples without the mean in LSB.
+ */
+uint16_t vibration_spectrum(struct vibration *vibration);
+
+/**
+ * @brief Analyze a full block and start a new one.
+ * A sine wave is reported with its amplitude (within 3 %) and frequency (within 1/20 of a bin) as long as it is
+ * at least 6 bins away from a stronger one. The RMS squared is 16/3 times the sum of all band energies (within 10 %).
+ *
+ * @param[in] vibration A full block.
+ * @param[in] sample_rate Sample rate in millihertz, up to 9000000.
+ * @param[out] result The result.
+ */
+void vibration_analyze(struct vibration *vibration, uint32_t sample_rate, struct vibration_result *result);
+
+#endif /* VIBRATION_H_ */
@@ -6,6 +6,141 @@
 */
 
 #include "max30101.h"
+#include <stddef.h>
+
+#ifdef MAX30101_MFIO_INTERRUPT
+#include <avr/interrupt.h>
+
+#if MAX30101_MFIO_INTERRUPT == 0
+#define MAX30101_MFIO_VECTOR INT0_vect
+#define MAX30101_MFIO_ENABLE (1 << INT0)
+#define MAX30101_MFIO_IS_LOW() (!(PIND & (1 << PD2)))
+#elif MAX30101_MFIO_INTERRUPT == 1
+#define MAX30101_MFIO_VECTOR INT1_vect
+#define MAX30101_MFIO_ENABLE (1 << INT1)
+#define MAX30101_MFIO_IS_LOW() (!(PIND & (1 << PD3)))
+#elif MAX30101_MFIO_INTERRUPT == 2
+#define MAX30101_MFIO_VECTOR INT2_vect
+#define MAX30101_MFIO_ENABLE (1 << INT2)
+#define MAX30101_MFIO_IS_LOW() (!(PINB & (1 << PB2)))
+#else
+#error "MAX30101_MFIO_INTERRUPT has to be 0, 1 or 2"
+#endif
+
+// Set by the ISR when the sensor hub has new data
+static volatile uint8_t max30101_data_ready = 0;
+
+ISR(MAX30101_MFIO_VECTOR)
+{
+	max30101_data_ready = 1;
+}
+
+/**
+* @brief Configure and enable the external interrupt for MFIO (falling edge, pull-up).
+*/
+static void max30101_mfio_enable()
+{
+#if MAX30101_MFIO_INTERRUPT == 0
+	DDRD &= ~(1 << PD2);
+	PORTD |= (1 << PD2);
+	MCUCR = (MCUCR & ~(1 << ISC00)) | (1 << ISC01);
+	GIFR = (1 << INTF0);
+#elif MAX30101_MFIO_INTERRUPT == 1
+	DDRD &= ~(1 << PD3);
+	PORTD |= (1 << PD3);
+	MCUCR = (MCUCR & ~(1 << ISC10)) | (1 << ISC11);
+	GIFR = (1 << INTF1);
+#else
+	DDRB &= ~(1 << PB2);
+	PORTB |= (1 << PB2);
+	MCUCSR &= ~(1 << ISC2);
+	GIFR = (1 << INTF2);
+#endif
+	// Data may already be waiting
+	max30101_data_ready = 1;
+	GICR |= MAX30101_MFIO_ENABLE;
+}
+#endif
+
+// Steps of max30101_poll
+#define MAX30101_STATE_IDLE 0
+#define MAX30101_STATE_STATUS 1
+#define MAX30101_STATE_COUNT 2
+#define MAX30101_STATE_REPORT 3
+
+static uint8_t max30101_state = MAX30101_STATE_IDLE;
+
+// Time the last command was sent in ms
+static uint16_t max30101_command_time = 0;
+
+// Number of reports requested from the output FIFO
+static uint8_t max30101_report_count = 0;
+
+/**
+* @brief Send a command to the sensor hub.
+*
+* @param[in] family The command family.
+* @param[in] index The command index.
+*/
+static void max30101_send_command(uint8_t family, uint8_t index)
+{
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(family);
+	i2c_master_sendChar(index);
+	i2c_master_stop();
+}
+
+/**
+* @brief Read the response of the last command from the sensor hub.
+*
+* @param[out] data Array to store the bytes following the status byte.
+* @param[in] length Number of bytes following the status byte.
+* @return The status byte, MAX30101_STATUS_SUCCESS if the data is valid.
+*/
+static uint8_t max30101_read_response(uint8_t data[], uint8_t length)
+{
+	uint8_t status;
+
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x01);
+	status = i2c_master_receiveChar(length ? 0x01 : 0x00);
+	for (uint8_t byte = 0; byte < length; byte++)
+	{
+		data[byte] = i2c_master_receiveChar(byte < length - 1 ? 0x01 : 0x00);
+	}
+	i2c_master_stop();
+
+	return status;
+}
+
+/**
+* @brief Convert an algorithm report into measurement values.
+*
+* @param[in] report MAX30101_REPORT_LENGTH bytes from the output FIFO.
+* @param[out] values Array to store the measurement values.
+* @param[in] length The number of values to store (1-3).
+*/
+static void max30101_transform(const uint8_t report[], uint16_t values[], uint8_t length)
+{
+	switch(length)
+	{
+		case 3:
+		values[2] = (uint16_t)(report[7] << 8 | report[8]); // Store 3rd value
+		case 2:
+		values[1] = (uint16_t)(report[3] << 8 | report[4]); // Store 2nd value
+		case 1:
+		values[0] = (uint16_t)(report[0] << 8 | report[1]); // Store 1st value
+		break;
+		
+		default:
+		// Initialize values to zero if length is invalid
+		values[0] = 0x0000;
+		values[1] = 0x0000;
+		values[2] = 0x0000;
+		break;
+	}
+}
 
 void max30101_start_measurements()
 {
@@ -16,6 +151,16 @@ void max30101_start_measurements()
 	i2c_master_sendChar(0x00);
 	i2c_master_sendChar(0x02); // Algorithm Data
 	i2c_master_stop();
+	_delay_ms(MAX30101_COMMAND_DELAY_MS);
+	
+	// Report data ready for every report, MFIO relies on this
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(0x10); // Set FIFO threshold
+	i2c_master_sendChar(0x01);
+	i2c_master_sendChar(0x01); // 1 report
+	i2c_master_stop();
+	_delay_ms(MAX30101_COMMAND_DELAY_MS);
 	
 	// Enable the AGC
 	i2c_master_start();
@@ -40,6 +185,54 @@ void max30101_start_measurements()
 	i2c_master_sendChar(0x02); 
 	i2c_master_sendChar(0x01); // Enable algorithm
 	i2c_master_stop();
+	
+#ifdef MAX30101_MFIO_INTERRUPT
+	max30101_mfio_enable();
+#endif
+}
+
+void max30101_start_raw_measurements()
+{
+	// Set output mode
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(0x10); // Set output mode
+	i2c_master_sendChar(0x00);
+	i2c_master_sendChar(0x01); // Sensor Data
+	i2c_master_stop();
+	_delay_ms(MAX30101_COMMAND_DELAY_MS);
+	
+	// Report data ready for every sample
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(0x10); // Set FIFO threshold
+	i2c_master_sendChar(0x01);
+	i2c_master_sendChar(0x01); // 1 sample
+	i2c_master_stop();
+	_delay_ms(MAX30101_COMMAND_DELAY_MS);
+	
+	// Enable the MAX30101 sensor
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(0x44); // Sensor Mode Enable
+	i2c_master_sendChar(0x03);
+	i2c_master_sendChar(0x01); // Enable MAX30101 sensor
+	i2c_master_stop();
+	_delay_ms(40); // The sensor needs 40 ms to start
+	
+	// Set the sample rate of the MAX30101
+	i2c_master_start();
+	i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x00);
+	i2c_master_sendChar(0x40); // Write register
+	i2c_master_sendChar(0x03); // MAX30101
+	i2c_master_sendChar(MAX30101_REG_SPO2_CONFIG);
+	i2c_master_sendChar(MAX30101_SPO2_CONFIG_100HZ);
+	i2c_master_stop();
+	_delay_ms(MAX30101_COMMAND_DELAY_MS);
+	
+#ifdef MAX30101_MFIO_INTERRUPT
+	max30101_mfio_enable();
+#endif
 }
 
 void max30101_single_measurement(uint16_t values[], uint8_t length)
@@ -64,24 +257,188 @@ void max30101_single_measurement(uint16_t values[], uint8_t length)
 	received_bytes[8] = i2c_master_receiveChar(0x00); // Read the last byte
 	i2c_master_stop();
 	
-	// Transform Output
+	max30101_transform(received_bytes, values, length);
+}
+
+/**
+* @brief The state machine behind `max30101_poll_reports` and `max30101_poll_raw`.
+*
+* @param[in] now_ms The current time in milliseconds.
+* @param[out] reports Array to store algorithm reports, NULL in raw mode.
+* @param[out] samples Array to store raw samples, NULL in algorithm mode.
+* @param[in] max Size of the array.
+* @return Number of reports or samples stored.
+*/
+static uint8_t max30101_poll_fifo(uint16_t now_ms, struct max30101_report reports[], struct max30101_raw_sample samples[], uint8_t max)
+{
+	uint8_t received_bytes[MAX30101_RAW_SAMPLE_LENGTH];
+	uint8_t length = samples ? MAX30101_RAW_SAMPLE_LENGTH : MAX30101_REPORT_LENGTH;
+	uint8_t status;
+
+	// No room for a report, do not start a read which would not be completed
+	if (max == 0)
+	{
+		return 0;
+	}
+
+	switch(max30101_state)
+	{
+		case MAX30101_STATE_IDLE:
+#ifdef MAX30101_MFIO_INTERRUPT
+		if (!max30101_data_ready)
+		{
+			// An edge is missed if MFIO is still low after the last read, poll while it stays low
+			if (!MAX30101_MFIO_IS_LOW() || (uint16_t)(now_ms - max30101_command_time) < MAX30101_POLL_INTERVAL_MS)
+			{
+				return 0;
+			}
+		}
+		max30101_data_ready = 0;
+
+		// MFIO already signaled new data, no need to ask for the status
+		max30101_send_command(0x12, 0x00); // Get the number of samples in the output FIFO
+		max30101_command_time = now_ms;
+		max30101_state = MAX30101_STATE_COUNT;
+		return 0;
+#else
+		if ((uint16_t)(now_ms - max30101_command_time) < MAX30101_POLL_INTERVAL_MS)
+		{
+			return 0;
+		}
+		max30101_send_command(0x00, 0x00); // Read sensor hub status
+		max30101_command_time = now_ms;
+		max30101_state = MAX30101_STATE_STATUS;
+		return 0;
+#endif
+
+		case MAX30101_STATE_STATUS:
+		if ((uint16_t)(now_ms - max30101_command_time) < MAX30101_COMMAND_DELAY_MS)
+		{
+			return 0;
+		}
+		status = max30101_read_response(received_bytes, 1);
+		if (status == MAX30101_STATUS_BUSY)
+		{
+			return 0; // Ask again on the next call
+		}
+		if (status != MAX30101_STATUS_SUCCESS || !(received_bytes[0] & MAX30101_HUB_STATUS_DATA_READY))
+		{
+			max30101_state = MAX30101_STATE_IDLE; // Nothing new, wait for the poll interval
+			return 0;
+		}
+		max30101_send_command(0x12, 0x00); // Get the number of samples in the output FIFO
+		max30101_command_time = now_ms;
+		max30101_state = MAX30101_STATE_COUNT;
+		return 0;
+
+		case MAX30101_STATE_COUNT:
+		if ((uint16_t)(now_ms - max30101_command_time) < MAX30101_COMMAND_DELAY_MS)
+		{
+			return 0;
+		}
+		status = max30101_read_response(received_bytes, 1);
+		if (status == MAX30101_STATUS_BUSY)
+		{
+			return 0;
+		}
+		if (status != MAX30101_STATUS_SUCCESS || received_bytes[0] == 0)
+		{
+			max30101_state = MAX30101_STATE_IDLE;
+			return 0;
+		}
+		max30101_report_count = (received_bytes[0] < max) ? received_bytes[0] : max;
+		max30101_send_command(0x12, 0x01); // Read data stored in output FIFO
+		max30101_command_time = now_ms;
+		max30101_state = MAX30101_STATE_REPORT;
+		return 0;
+
+		case MAX30101_STATE_REPORT:
+		if ((uint16_t)(now_ms - max30101_command_time) < MAX30101_COMMAND_DELAY_MS)
+		{
+			return 0;
+		}
+		// All reports in one transaction
+		i2c_master_start();
+		i2c_master_sendAddress(MAX30101_I2C_ADDRESS, 0x01);
+		status = i2c_master_receiveChar(0x01);
+		if (status != MAX30101_STATUS_SUCCESS)
+		{
+			// No valid reports follow, end the transaction before anything is copied
+			i2c_master_receiveChar(0x00);
+			i2c_master_stop();
+			if (status != MAX30101_STATUS_BUSY)
+			{
+				max30101_state = MAX30101_STATE_IDLE; // Ask for the status again after the poll interval
+			}
+			return 0;
+		}
+		for (uint8_t report = 0; report < max30101_report_count; report++)
+		{
+			for (uint8_t byte = 0; byte < length; byte++)
+			{
+				uint8_t last = (report == max30101_report_count - 1) && (byte == length - 1);
+				received_bytes[byte] = i2c_master_receiveChar(last ? 0x00 : 0x01);
+			}
+			if (samples)
+			{
+				samples[report].ir = (uint32_t)received_bytes[0] << 16 | (uint16_t)(received_bytes[1] << 8) | received_bytes[2];
+				samples[report].red = (uint32_t)received_bytes[3] << 16 | (uint16_t)(received_bytes[4] << 8) | received_bytes[5];
+			}
+			else
+			{
+				reports[report].heart_rate = (uint16_t)(received_bytes[0] << 8 | received_bytes[1]);
+				reports[report].spo2 = (uint16_t)(received_bytes[3] << 8 | received_bytes[4]);
+				reports[report].interbeat_interval = (uint16_t)(received_bytes[7] << 8 | received_bytes[8]);
+			}
+		}
+		i2c_master_stop();
+
+		// Check the status again right away, more reports may be queued
+		max30101_command_time = now_ms - MAX30101_POLL_INTERVAL_MS;
+		max30101_state = MAX30101_STATE_IDLE;
+#ifdef MAX30101_MFIO_INTERRUPT
+		if (max30101_report_count == max)
+		{
+			max30101_data_ready = 1;
+		}
+#endif
+		return max30101_report_count;
+	}
+
+	max30101_state = MAX30101_STATE_IDLE;
+	return 0;
+}
+
+uint8_t max30101_poll_reports(uint16_t now_ms, struct max30101_report reports[], uint8_t max)
+{
+	return max30101_poll_fifo(now_ms, reports, NULL, max);
+}
+
+uint8_t max30101_poll_raw(uint16_t now_ms, struct max30101_raw_sample samples[], uint8_t max)
+{
+	return max30101_poll_fifo(now_ms, NULL, samples, max);
+}
+
+uint8_t max30101_poll(uint16_t now_ms, uint16_t values[], uint8_t length)
+{
+	struct max30101_report report;
+
+	if (!max30101_poll_reports(now_ms, &report, 1))
+	{
+		return 0;
+	}
+
 	switch(length)
 	{
 		case 3:
-		values[2] = (uint16_t)(received_bytes[7] << 8 | received_bytes[8]); // Store 3rd value
+		values[2] = report.interbeat_interval;
 		case 2:
-		values[1] = (uint16_t)(received_bytes[3] << 8 | received_bytes[4]); // Store 2nd value
+		values[1] = report.spo2;
 		case 1:
-		values[0] = (uint16_t)(received_bytes[0] << 8 | received_bytes[1]); // Store 1st value
-		break;
-		
-		default:
-		// Initialize values to zero if length is invalid
-		values[0] = 0x0000;
-		values[1] = 0x0000;
-		values[2] = 0x0000;
+		values[0] = report.heart_rate;
 		break;
 	}
+	return 1;
 }
 
 void max30101_stop_measurements()
@@ -101,4 +458,8 @@ void max30101_stop_measurements()
 	i2c_master_sendChar(0x02);
 	i2c_master_sendChar(0x00); // Disable the Algorithm
 	i2c_master_stop();
+	
+#ifdef MAX30101_MFIO_INTERRUPT
+	GICR &= ~MAX30101_MFIO_ENABLE;
+#endif
 }
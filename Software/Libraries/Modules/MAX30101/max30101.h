@@ -9,8 +9,26 @@
 #define MAX30101_H_
 
 #include "i2c_master.h"
+#include <util/delay.h>
 
 
+/**
+* @def MAX30101_MFIO_INTERRUPT
+* @brief Use the MFIO pin of the sensor hub as an external interrupt of the ATmega16A.
+*
+* @note: The value selects the pin: 0 = INT0 (PD2), 1 = INT1 (PD3), 2 = INT2 (PB2). Global interrupts have to be enabled with sei().
+* The hub pulls MFIO low when new data is in the output FIFO. The polling functions then only use the I2C bus after an interrupt
+* and skip the status request, so the data is read as soon as the main loop calls them.
+* The interrupt triggers on the falling edge. If MFIO is still low after the data was read, no new edge follows,
+* so the polling functions then fall back to reading the FIFO every MAX30101_POLL_INTERVAL_MS until MFIO is released.
+*
+* To enable, uncomment the following line:
+* @code
+* #define MAX30101_MFIO_INTERRUPT 0
+* @endcode
+*/
+//#define MAX30101_MFIO_INTERRUPT 0
+
 // I2C address for the MAX30101 sensor
 
 /**
@@ -21,6 +39,89 @@
 */
 #define MAX30101_I2C_ADDRESS 0x55
 
+/**
+ * @def MAX30101_COMMAND_DELAY_MS
+ *
+ * Time the sensor hub needs to process a command before the response can be read.
+ */
+#define MAX30101_COMMAND_DELAY_MS 2
+
+/**
+ * @def MAX30101_POLL_INTERVAL_MS
+ *
+ * Time between two status requests while the sensor hub has no new data.
+ * With MAX30101_MFIO_INTERRUPT only used while MFIO stays low without a new edge.
+ */
+#define MAX30101_POLL_INTERVAL_MS 10
+
+/**
+ * @def MAX30101_STATUS_SUCCESS
+ *
+ * Status byte in front of every response of the sensor hub if the command was successful.
+ */
+#define MAX30101_STATUS_SUCCESS 0x00
+
+/**
+ * @def MAX30101_STATUS_BUSY
+ *
+ * Status byte of the sensor hub if the command is not finished yet. The response has to be read again later.
+ */
+#define MAX30101_STATUS_BUSY 0xFE
+
+/**
+ * @def MAX30101_HUB_STATUS_DATA_READY
+ *
+ * Bit in the sensor hub status (family 0x00, index 0x00) which is set when the output FIFO holds new data.
+ */
+#define MAX30101_HUB_STATUS_DATA_READY (1 << 3)
+
+/**
+ * @def MAX30101_REPORT_LENGTH
+ *
+ * Number of bytes of one algorithm report in the output FIFO.
+ */
+#define MAX30101_REPORT_LENGTH 9
+
+/**
+ * @def MAX30101_RAW_SAMPLE_LENGTH
+ *
+ * Number of bytes of one raw sample in the output FIFO: 4 LED channels with 3 bytes each.
+ */
+#define MAX30101_RAW_SAMPLE_LENGTH 12
+
+/**
+ * @def MAX30101_REG_SPO2_CONFIG
+ *
+ * Register of the MAX30101 (not the sensor hub) which sets the ADC range, sample rate and LED pulse width.
+ */
+#define MAX30101_REG_SPO2_CONFIG 0x0A
+
+/**
+ * @def MAX30101_SPO2_CONFIG_100HZ
+ *
+ * Value of MAX30101_REG_SPO2_CONFIG for 100 samples per second, 4096 nA ADC range and 411 us pulses (18 bit).
+ */
+#define MAX30101_SPO2_CONFIG_100HZ 0x27
+
+/**
+* @brief One algorithm report of the output FIFO.
+*/
+struct max30101_report
+{
+	uint16_t heart_rate;			// Heart rate
+	uint16_t spo2;					// SpO2
+	uint16_t interbeat_interval;	// Interbeat interval (IBI)
+};
+
+/**
+* @brief One raw sample of the output FIFO.
+*/
+struct max30101_raw_sample
+{
+	uint32_t ir;					// IR LED channel (18 bit)
+	uint32_t red;					// Red LED channel (18 bit)
+};
+
 /**
 * @brief Starts measurements on the MAX30101 sensor.
 *
@@ -28,6 +129,14 @@
 */
 void max30101_start_measurements();
 
+/**
+* @brief Starts raw measurements on the MAX30101 sensor.
+*
+* Instead of the results of the algorithm, the sensor hub outputs the raw LED samples at 100 Hz.
+* Read them with `max30101_poll_raw`, e.g. for `max30101_beat_update`. Stop with `max30101_stop_measurements`.
+*/
+void max30101_start_raw_measurements();
+
 /**
 * @brief Perform a single measurement
 *
@@ -46,6 +155,46 @@ void max30101_start_measurements();
 */
 void max30101_single_measurement(uint16_t values[], uint8_t length);
 
+/**
+* @brief Continue a measurement without blocking.
+*
+* Call this as often as possible from the main loop. Every call does at most one step and returns immediately:
+* it asks the sensor hub for its status, and once the hub reports new data, reads it from the output FIFO.
+* The hub is given MAX30101_COMMAND_DELAY_MS to answer every command, so no delay is needed in between.
+*
+* @param[in] now_ms The current time in milliseconds, e.g. from a timer. It may overflow.
+* @param[out] values Array to store the measurement values, only written if 1 is returned.
+* @param[in] length The number of values to store (1-3), see `max30101_single_measurement`.
+* @return 1 if new values were stored, 0 otherwise.
+*/
+uint8_t max30101_poll(uint16_t now_ms, uint16_t values[], uint8_t length);
+
+/**
+* @brief Continue a measurement without blocking and read all queued reports at once.
+*
+* Works like `max30101_poll`, but once the hub reports new data it asks for the number of reports in the
+* output FIFO (family 0x12, index 0x00) and reads up to max of them in a single I2C transaction.
+* Use either this function or `max30101_poll`, they share their state.
+*
+* @param[in] now_ms The current time in milliseconds, e.g. from a timer. It may overflow.
+* @param[out] reports Array to store the reports.
+* @param[in] max Size of the array (1-255).
+* @return Number of reports stored, 0 if there is nothing new.
+*/
+uint8_t max30101_poll_reports(uint16_t now_ms, struct max30101_report reports[], uint8_t max);
+
+/**
+* @brief Continue a raw measurement without blocking and read all queued samples at once.
+*
+* Works like `max30101_poll_reports` after `max30101_start_raw_measurements`.
+*
+* @param[in] now_ms The current time in milliseconds, e.g. from a timer. It may overflow.
+* @param[out] samples Array to store the samples.
+* @param[in] max Size of the array (1-255).
+* @return Number of samples stored, 0 if there is nothing new.
+*/
+uint8_t max30101_poll_raw(uint16_t now_ms, struct max30101_raw_sample samples[], uint8_t max);
+
 /**
 * @brief Stops measurements on the MAX30101 sensor.
 *
@@ -0,0 +1,117 @@
+/*
+* max30101_beat.c
+*
+* Created: 19.10.2026 15:10:31
+*/
+
+#include "max30101_beat.h"
+
+void max30101_beat_init(struct max30101_beat *beat, uint16_t sample_rate)
+{
+	beat->baseline = -1; // Set by the first sample
+	beat->pulse = 0;
+	beat->peak = 0;
+	beat->envelope = 0;
+	beat->since_beat = 0;
+	beat->sample_rate = sample_rate;
+	beat->index = 0;
+	beat->count = 0;
+	beat->rising = 0;
+	beat->started = 0;
+}
+
+uint8_t max30101_beat_update(struct max30101_beat *beat, uint32_t sample)
+{
+	int32_t value = (int32_t)(sample & 0x7FFFF) << 8;
+	int32_t previous = beat->pulse;
+	uint8_t detected = 0;
+
+	if (beat->baseline < 0)
+	{
+		beat->baseline = value;
+	}
+
+	// High pass at about 0.5 Hz (100 Hz / (2 pi 32)) removes the DC level and breathing
+	beat->baseline += (value - beat->baseline) >> 5;
+
+	// Blood absorbs light, so the raw value falls with every beat: invert it.
+	// Low pass at about 4 Hz (100 Hz / (2 pi 4)) removes noise.
+	beat->pulse += (((beat->baseline - value) >> 8) - beat->pulse) >> 2;
+
+	// Let the envelope follow falling amplitudes within a few seconds
+	beat->envelope -= beat->envelope >> 8;
+
+	if (beat->since_beat < UINT16_MAX)
+	{
+		beat->since_beat++;
+	}
+
+	if (beat->pulse > previous)
+	{
+		beat->rising = 1;
+		beat->peak = beat->pulse;
+	}
+	else if (beat->rising)
+	{
+		// Maximum passed: a beat if it is high enough and not within 300 ms (200 bpm) of the last one
+		beat->rising = 0;
+		if (beat->peak > 0 && beat->peak >= (beat->envelope >> 1) && beat->since_beat >= (uint16_t)(beat->sample_rate * 3 / 10))
+		{
+			beat->envelope += (beat->peak - beat->envelope) >> 2;
+
+			// Intervals above 2 s (30 bpm) are gaps, not beats. The first beat has no previous one.
+			if (beat->started && beat->since_beat <= 2 * beat->sample_rate)
+			{
+				beat->intervals[beat->index] = beat->since_beat;
+				beat->index = (beat->index + 1) % MAX30101_BEAT_AVERAGE;
+				if (beat->count < MAX30101_BEAT_AVERAGE)
+				{
+					beat->count++;
+				}
+			}
+			else
+			{
+				// Start over, intervals before the gap are not averaged with new ones
+				beat->index = 0;
+				beat->count = 0;
+			}
+			beat->since_beat = 0;
+			beat->started = 1;
+			detected = 1;
+		}
+		else if (beat->peak > beat->envelope)
+		{
+			// Too early, but keep the envelope up to date
+			beat->envelope = beat->peak;
+		}
+	}
+
+	return detected;
+}
+
+uint16_t max30101_beat_rate(const struct max30101_beat *beat)
+{
+	uint32_t sum = 0;
+
+	if (beat->count == 0)
+	{
+		return 0;
+	}
+	for (uint8_t i = 0; i < beat->count; i++)
+	{
+		sum += beat->intervals[i];
+	}
+	// 600 * samples per second * beats / samples in 0.1 bpm
+	return (uint16_t)((600UL * beat->sample_rate * beat->count + sum / 2) / sum);
+}
+
+uint16_t max30101_beat_interval(const struct max30101_beat *beat)
+{
+	uint8_t last = (beat->index + MAX30101_BEAT_AVERAGE - 1) % MAX30101_BEAT_AVERAGE;
+
+	if (beat->count == 0)
+	{
+		return 0;
+	}
+	return (uint16_t)((1000UL * beat->intervals[last] + beat->sample_rate / 2) / beat->sample_rate);
+}
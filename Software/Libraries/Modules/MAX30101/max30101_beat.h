@@ -0,0 +1,77 @@
+/*
+* max30101_beat.h
+*
+* Beat detection on raw PPG samples of the MAX30101, in integer arithmetic.
+* The detector works on one LED channel (IR gives the strongest pulse) and needs no
+* multiplications or divisions per sample, only when a beat was found.
+*
+* Created: 19.10.2026 15:10:42
+*/
+
+#ifndef MAX30101_BEAT_H_
+#define MAX30101_BEAT_H_
+
+#include <stdint.h>
+
+/**
+ * @def MAX30101_BEAT_AVERAGE
+ *
+ * Number of interbeat intervals averaged for the heart rate.
+ */
+#define MAX30101_BEAT_AVERAGE 4
+
+/**
+* @brief State of the beat detector.
+*/
+struct max30101_beat
+{
+	int32_t baseline;			// Slowly following DC level in 1/256 LSB
+	int32_t pulse;				// Low pass filtered pulse wave without DC, higher with more blood
+	int32_t peak;				// Highest value of pulse since it started rising
+	int32_t envelope;			// Height of recent pulses, decays slowly
+	uint16_t since_beat;		// Samples since the last beat
+	uint16_t sample_rate;		// Samples per second
+	uint16_t intervals[MAX30101_BEAT_AVERAGE];	// Last interbeat intervals in samples
+	uint8_t index;				// Next entry of intervals
+	uint8_t count;				// Valid entries of intervals
+	uint8_t rising;				// 1 while pulse is rising
+	uint8_t started;			// 1 once a beat was detected, since_beat is then an interval
+};
+
+/**
+* @brief Reset the beat detector.
+*
+* @param[out] beat The beat detector.
+* @param[in] sample_rate Samples per second, e.g. 100.
+*/
+void max30101_beat_init(struct max30101_beat *beat, uint16_t sample_rate);
+
+/**
+* @brief Feed one sample into the beat detector.
+*
+* A beat is reported at the maximum of the pulse wave (the minimum of the raw LED value),
+* which is delayed by about 50 ms by the low pass filter.
+*
+* @param[in] beat The beat detector.
+* @param[in] sample Raw LED value, e.g. `max30101_raw_sample.ir`.
+* @return 1 if a beat was detected at this sample, 0 otherwise.
+*/
+uint8_t max30101_beat_update(struct max30101_beat *beat, uint32_t sample);
+
+/**
+* @brief Get the heart rate averaged over the last MAX30101_BEAT_AVERAGE beats.
+*
+* @param[in] beat The beat detector.
+* @return The heart rate in 0.1 bpm (like the algorithm reports of the sensor hub), 0 if unknown.
+*/
+uint16_t max30101_beat_rate(const struct max30101_beat *beat);
+
+/**
+* @brief Get the last interbeat interval.
+*
+* @param[in] beat The beat detector.
+* @return The time between the last two beats in ms, 0 if unknown.
+*/
+uint16_t max30101_beat_interval(const struct max30101_beat *beat);
+
+#endif /* MAX30101_BEAT_H_ */
@@ -0,0 +1,247 @@
+/*
+* test_host.c
+*
+* Host replay benchmark for the beat detector. Feeds PPG samples through
+* `max30101_beat_update` and compares the beats with the true ones.
+*
+* Build and run on Linux:
+*     gcc -O2 -o test_host test_host.c max30101_beat.c -lm
+*     ./test_host                          (synthetic PPG with changing heart rate, noise and breathing, and a signal dropout)
+*     ./test_host recording.csv 100        (recording, sample rate in Hz)
+*
+* A recording has one sample per line: the raw IR value, optionally followed by ",1" on samples
+* with a reference beat. Without reference beats only the detected heart rate is printed.
+*
+* Created: 19.10.2026 15:34:20
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "max30101_beat.h"
+
+#define MAX_SAMPLES 200000
+
+static uint32_t samples[MAX_SAMPLES];
+static uint8_t reference[MAX_SAMPLES];		// 1 at a true beat
+static double reference_rate[MAX_SAMPLES];	// True heart rate in bpm, 0 if unknown
+
+static double gauss(double x, double center, double width)
+{
+	return exp(-(x - center) * (x - center) / (2 * width * width));
+}
+
+// 10 minutes of PPG: heart rate drifting between 45 and 180 bpm, breathing, drift and noise
+static int generate(int rate)
+{
+	int count = 600 * rate;
+	double phase = 0;
+	double bpm = 70;
+
+	for (int n = 0; n < count; n++)
+	{
+		double t = (double)n / rate;
+		double target = 110 + 65 * sin(2 * M_PI * t / 240) + 10 * sin(2 * M_PI * t / 37);
+		double value;
+
+		bpm += (target - bpm) * 0.01 / rate;
+		phase += bpm / 60 / rate;
+		if (phase >= 1)
+		{
+			phase -= 1;
+			reference[n] = 1;
+		}
+
+		// Systolic peak and dicrotic wave, absorbed light lowers the raw value
+		value = 100000 - 800 * (gauss(phase, 0.15, 0.06) + 0.35 * gauss(phase, 0.45, 0.08) + 0.35 * gauss(phase + 1, 0.45, 0.08));
+		value += 600 * sin(2 * M_PI * t / 4.5);					// Breathing
+		value += 2000 * sin(2 * M_PI * t / 97);					// Slow drift
+		value += 25 * ((double)rand() / RAND_MAX - 0.5);		// Noise
+		samples[n] = (uint32_t)value;
+		reference_rate[n] = bpm;
+	}
+	return count;
+}
+
+static int load(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[128];
+	int count = 0;
+
+	if (!file)
+	{
+		perror(path);
+		return 0;
+	}
+	while (count < MAX_SAMPLES && fgets(line, sizeof(line), file))
+	{
+		unsigned long value;
+		int beat = 0;
+
+		if (sscanf(line, "%lu,%d", &value, &beat) >= 1)
+		{
+			samples[count] = value;
+			reference[count] = beat;
+			count++;
+		}
+	}
+	fclose(file);
+	return count;
+}
+
+// Pulse wave at a fixed heart rate, flat while bpm is 0
+static double pulse(double *phase, double bpm, int rate)
+{
+	*phase += bpm / 60 / rate;
+	if (*phase >= 1)
+	{
+		*phase -= 1;
+	}
+	if (bpm == 0)
+	{
+		return 100000;
+	}
+	return 100000 - 800 * (gauss(*phase, 0.15, 0.06) + 0.35 * gauss(*phase, 0.45, 0.08) + 0.35 * gauss(*phase + 1, 0.45, 0.08));
+}
+
+// 20 s at 60 bpm, 3 s without signal, 20 s at 120 bpm: no interval from before the gap may be averaged in
+static int test_dropout(int rate)
+{
+	struct max30101_beat beat;
+	double phase = 0;
+	int failures = 0, rated = 0;
+
+	max30101_beat_init(&beat, rate);
+	for (int n = 0; n < 43 * rate; n++)
+	{
+		double bpm = n < 20 * rate ? 60 : n < 23 * rate ? 0 : 120;
+		if (!max30101_beat_update(&beat, (uint32_t)pulse(&phase, bpm, rate)))
+		{
+			continue;
+		}
+		uint16_t heart_rate = max30101_beat_rate(&beat);
+		if (n < 23 * rate)
+		{
+			continue;
+		}
+		// The first beat after the gap has no interval yet, all later ones are at 120 bpm
+		if (heart_rate != 0 && (heart_rate < 1150 || heart_rate > 1250))
+		{
+			printf("dropout: %.1f bpm at %.2f s, expected 120 bpm\n", heart_rate / 10.0, (double)n / rate);
+			failures++;
+		}
+		rated += heart_rate != 0;
+	}
+	if (rated == 0)
+	{
+		printf("dropout: no heart rate after the gap\n");
+		failures++;
+	}
+
+	// The first beat after init has no interval either
+	max30101_beat_init(&beat, rate);
+	phase = 0;
+	for (int n = 0; n < 5 * rate; n++)
+	{
+		if (max30101_beat_update(&beat, (uint32_t)pulse(&phase, 60, rate)))
+		{
+			if (max30101_beat_rate(&beat) != 0)
+			{
+				printf("init: %.1f bpm at the first beat, expected none\n", max30101_beat_rate(&beat) / 10.0);
+				failures++;
+			}
+			break;
+		}
+	}
+
+	printf("dropout test:        %s\n", failures ? "FAILED" : "passed");
+	return failures;
+}
+
+int main(int argc, char *argv[])
+{
+	int rate = argc > 2 ? atoi(argv[2]) : 100;
+	int count = argc > 1 ? load(argv[1]) : generate(rate);
+	int window = rate / 5;		// A detected beat within +-200 ms of a true one counts as found
+	int truth = 0, found = 0, detected = 0, compared = 0;
+	double rate_error_max = 0, rate_error_sum = 0;
+	struct max30101_beat beat;
+	uint8_t *matched = calloc(count, 1);
+
+	if (count == 0)
+	{
+		fprintf(stderr, "no samples\n");
+		return 1;
+	}
+	if (argc <= 1 && test_dropout(rate))
+	{
+		return 1;
+	}
+
+	max30101_beat_init(&beat, rate);
+	for (int n = 0; n < count; n++)
+	{
+		truth += reference[n];
+		if (max30101_beat_update(&beat, samples[n]))
+		{
+			detected++;
+
+			// Match with the closest unmatched true beat
+			for (int k = n - window; k <= n + window; k++)
+			{
+				if (k >= 0 && k < count && reference[k] && !matched[k])
+				{
+					matched[k] = 1;
+					found++;
+					break;
+				}
+			}
+
+			// Heart rate after the first 10 seconds
+			if (reference_rate[n] > 0 && n > 10 * rate)
+			{
+				double error = fabs(max30101_beat_rate(&beat) / 10.0 - reference_rate[n]);
+				rate_error_max = fmax(rate_error_max, error);
+				rate_error_sum += error;
+				compared++;
+			}
+		}
+	}
+
+	// Speed
+	const int repeat = 50;
+	clock_t time = clock();
+	volatile uint8_t sink = 0;
+	for (int r = 0; r < repeat; r++)
+	{
+		max30101_beat_init(&beat, rate);
+		for (int n = 0; n < count; n++)
+		{
+			sink += max30101_beat_update(&beat, samples[n]);
+		}
+	}
+	time = clock() - time;
+	(void)sink;
+
+	printf("samples:             %d at %d Hz\n", count, rate);
+	printf("host time per sample: %.1f ns\n", 1e9 * time / CLOCKS_PER_SEC / ((double)repeat * count));
+	printf("beats:               %d detected, last heart rate %.1f bpm\n", detected, max30101_beat_rate(&beat) / 10.0);
+	if (truth)
+	{
+		double sensitivity = (double)found / truth;
+		double precision = detected ? (double)found / detected : 0;
+
+		printf("reference beats:     %d, sensitivity %.2f %%, precision %.2f %%\n", truth, sensitivity * 100, precision * 100);
+		if (compared)
+		{
+			printf("heart rate error:    mean %.2f bpm, max %.2f bpm\n", rate_error_sum / compared, rate_error_max);
+		}
+		free(matched);
+		return (sensitivity > 0.99 && precision > 0.99) ? 0 : 1;
+	}
+	free(matched);
+	return 0;
+}
@@ -19,6 +19,30 @@ uint16_t last_co2 = 0;         // CO2 concentration (ppm)
 uint16_t last_temperature = 0;  // Temperature
 uint16_t last_humidity = 0;     // Relative humidity
 
+// Steps of scd41_poll
+#define SCD41_STATE_IDLE 0
+#define SCD41_STATE_COMMAND 1		// Command requested, sent on the next poll
+#define SCD41_STATE_WAIT 2			// Waiting before the next data ready check
+#define SCD41_STATE_DATA_READY 3	// Data ready status requested
+#define SCD41_STATE_MEASUREMENT 4	// Measurement requested
+#define SCD41_STATE_STOPPING 5		// Stop command executing
+
+static uint8_t scd41_state = SCD41_STATE_IDLE;
+static uint16_t scd41_command = 0;			// Last requested command
+static uint16_t scd41_periodic = 0;			// Measurement interval in ms while periodic measurement mode is running, 0 otherwise
+static uint16_t scd41_command_time = 0;		// Time the last command was sent in ms
+static uint16_t scd41_wait_time = 0;		// Time to wait after scd41_command_time in ms
+static void (*scd41_callback)(uint16_t co2, uint16_t temperature_raw, uint16_t humidity_raw) = 0;
+
+/**
+ * @brief Get current sensor state
+ * @return 0 if stopped, 1 if running
+ */
+uint8_t scd41_get_current_state()
+{
+	return scd41_periodic != 0;
+}
+
 /**
  * @brief Get last measured CO2 value
  * @return CO2 concentration in ppm
@@ -46,6 +70,15 @@ uint16_t scd41_get_temperature_raw()
 	return last_temperature;
 }
 
+/**
+ * @brief Get last measured temperature without floating point
+ * @return Temperature in 0.01 degrees C
+ */
+int16_t scd41_get_temperature_centi()
+{
+	return scd41_convert_temperature_centi(last_temperature);
+}
+
 /**
  * @brief Get last measured humidity
  * @return relative humidity
@@ -64,11 +97,30 @@ uint16_t scd41_get_humidity_raw()
 	return last_humidity;
 }
 
+/**
+ * @brief Get last measured humidity without floating point
+ * @return Relative humidity in 0.01 percent
+ */
+uint16_t scd41_get_humidity_centi()
+{
+	return scd41_convert_humidity_centi(last_humidity);
+}
+
 /**
  * @brief Start periodic measurement mode
  */
 void scd41_start_periodic_measurement(){
 	scd41_sequence_send_command(SCD41_COMMAND_START_PRERIODIC_MEASUREMENT);
+	scd41_periodic = SCD41_PERIODIC_INTERVAL_MS;
+}
+
+/**
+ * @brief Start low power periodic measurement mode
+ */
+void scd41_start_low_power_periodic_measurement()
+{
+	scd41_sequence_send_command(SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT);
+	scd41_periodic = SCD41_LOW_POWER_INTERVAL_MS;
 }
 
 /**
@@ -92,6 +144,7 @@ void scd41_read_measurement()
 void scd41_stop_periodic_measurement(uint8_t wait)
 {
 	scd41_sequence_send_command(SCD41_COMMAND_STOP_PRERIODIC_MEASUREMENT);
+	scd41_periodic = 0;
 	
 	// Wait 500ms for command to complete if requested
 	if (wait)
@@ -104,35 +157,14 @@ void scd41_stop_periodic_measurement(uint8_t wait)
  * @brief Generate CRC8 checksum for 16-bit value
  * @param value Value to generate checksum for
  * @return CRC8 checksum
- * @note Based on: https://stackoverflow.com/a/51773839
  */
 uint8_t scd41_generate_checksum(uint16_t value)
 {
-	uint8_t crc = 0xff; // Initialize CRC with all bits set
-	
-	// Process each byte of the 16-bit value
-	for (uint8_t i = 0; i < 2; i++)
-	{
-		crc ^= (uint8_t)(value>>8*(1-i));  	// XOR the current byte into CRC
-
-		
-		// Process each bit using CRC-8 polynomial
-		for (uint8_t j = 0; j < 8; j++)
-		{
-			// If MSB is 1, shift left and XOR with polynomial 0x31
-			if ((crc & 0x80) != 0)
-			{
-				crc = (uint8_t)((crc << 1) ^ 0x31);
-			}
-			// If MSB is 0, just shift left
-			else
-			{
-				crc <= 1;
-			}
-		}
-	}
-	
-	return crc;
+	#ifdef SCD41_CRC_FULL_TABLE
+	return scd41_crc_byte_table(value);
+	#else
+	return scd41_crc_nibble_table(value);
+	#endif
 }
 
 /**
@@ -143,7 +175,7 @@ uint8_t scd41_generate_checksum(uint16_t value)
  */
 uint8_t scd41_check_checksum(uint16_t value, uint8_t checksum)
 {
-	return (uint8_t)(generate_checksum(value) == checksum);
+	return (uint8_t)(scd41_generate_checksum(value) == checksum);
 }
 
 /**
@@ -161,6 +193,247 @@ void scd41_measure_single_shot(uint8_t wait)
 	}
 }
 
+/**
+ * @brief Perform single measurement of temperature and humidity only
+ * @param wait If 1, waits 50ms for measurement
+ */
+void scd41_measure_single_shot_rht_only(uint8_t wait)
+{
+	scd41_sequence_send_command(SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY);
+	
+	// If wait parameter is set, delay for 50ms while measurement completes
+	if (wait)
+	{
+		_delay_ms(SCD41_EXECUTION_TIME_MEASURE_SINGLE_SHOT_RHT_ONLY_MS);
+	}
+}
+
+/**
+ * @brief Set the function to call when a new measurement was read
+ * @param callback Function to call, NULL for none
+ */
+void scd41_set_callback(void (*callback)(uint16_t co2, uint16_t temperature_raw, uint16_t humidity_raw))
+{
+	scd41_callback = callback;
+}
+
+/**
+ * @brief Select the command to send on the next poll
+ * @param command Command to send
+ */
+static void scd41_request(uint16_t command)
+{
+	// Only a command which is still executing delays the new one
+	if (scd41_state == SCD41_STATE_IDLE || scd41_state == SCD41_STATE_WAIT)
+	{
+		scd41_wait_time = 0;
+	}
+	scd41_command = command;
+	scd41_state = SCD41_STATE_COMMAND;
+}
+
+/**
+ * @brief Request periodic measurement mode
+ */
+void scd41_request_periodic_measurement()
+{
+	scd41_request(SCD41_COMMAND_START_PRERIODIC_MEASUREMENT);
+}
+
+/**
+ * @brief Request a single measurement
+ */
+void scd41_request_single_shot()
+{
+	scd41_request(SCD41_COMMAND_MEASURE_SINGLE_SHOT);
+}
+
+/**
+ * @brief Request low power periodic measurement mode
+ */
+void scd41_request_low_power_periodic_measurement()
+{
+	scd41_request(SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT);
+}
+
+/**
+ * @brief Request a single measurement of temperature and humidity only
+ */
+void scd41_request_single_shot_rht_only()
+{
+	scd41_request(SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY);
+}
+
+/**
+ * @brief Request to stop periodic measurement mode
+ */
+void scd41_request_stop()
+{
+	scd41_request(SCD41_COMMAND_STOP_PRERIODIC_MEASUREMENT);
+}
+
+/**
+ * @brief Check whether scd41_poll is waiting for the sensor
+ * @return 1 if busy, 0 if idle
+ */
+uint8_t scd41_is_busy()
+{
+	return scd41_state != SCD41_STATE_IDLE;
+}
+
+/**
+ * @brief Get the time until scd41_poll has something to do
+ * @param now_ms Current time in ms
+ * @return Time in ms, 0 if due, 0xFFFF if idle
+ */
+uint16_t scd41_get_idle_time(uint16_t now_ms)
+{
+	if (scd41_state == SCD41_STATE_IDLE)
+	{
+		return 0xFFFF;
+	}
+	
+	uint16_t elapsed = now_ms - scd41_command_time;
+	if (scd41_state == SCD41_STATE_COMMAND || elapsed >= scd41_wait_time)
+	{
+		return 0;
+	}
+	return scd41_wait_time - elapsed;
+}
+
+/**
+ * @brief Continue a measurement without blocking
+ * @param now_ms Current time in ms
+ * @return 1 if a new measurement was read, 0 otherwise
+ */
+uint8_t scd41_poll(uint16_t now_ms)
+{
+	uint16_t data[3];
+	uint8_t valid;
+	
+	// Wait until the sensor has processed the last command
+	if (!scd41_sequence_ready(now_ms))
+	{
+		return 0;
+	}
+	
+	switch (scd41_state)
+	{
+		case SCD41_STATE_COMMAND:
+		scd41_sequence_request(scd41_command, now_ms);
+		if (scd41_command == SCD41_COMMAND_STOP_PRERIODIC_MEASUREMENT)
+		{
+			scd41_periodic = 0;
+			scd41_state = SCD41_STATE_STOPPING;
+			return 0;
+		}
+		if (scd41_command == SCD41_COMMAND_START_PRERIODIC_MEASUREMENT)
+		{
+			scd41_periodic = SCD41_PERIODIC_INTERVAL_MS;
+			scd41_wait_time = scd41_periodic;	// First measurement
+		}
+		else if (scd41_command == SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT)
+		{
+			scd41_periodic = SCD41_LOW_POWER_INTERVAL_MS;
+			scd41_wait_time = scd41_periodic;
+		}
+		scd41_state = SCD41_STATE_WAIT;
+		return 0;
+		
+		case SCD41_STATE_WAIT:
+		scd41_sequence_request(SCD41_COMMAND_GET_DATA_READY_STATUS, now_ms);
+		scd41_state = SCD41_STATE_DATA_READY;
+		return 0;
+		
+		case SCD41_STATE_DATA_READY:
+		if (!scd41_sequence_receive(data, 1) || !(data[0] & SCD41_DATA_READY_MASK))
+		{
+			// Not ready yet or corrupted, check again later
+			scd41_wait_time = SCD41_POLL_INTERVAL_MS;
+			scd41_state = SCD41_STATE_WAIT;
+			return 0;
+		}
+		scd41_sequence_request(SCD41_COMMAND_READ_MEASUREMENT, now_ms);
+		scd41_state = SCD41_STATE_MEASUREMENT;
+		return 0;
+		
+		case SCD41_STATE_MEASUREMENT:
+		valid = scd41_sequence_receive(data, 3);
+		if (valid)
+		{
+			if (scd41_command != SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY)
+			{
+				last_co2 = data[0];	// Not measured in RHT only mode
+			}
+			last_temperature = data[1];
+			last_humidity = data[2];
+		}
+		
+		if (scd41_periodic)
+		{
+			// The next measurement is due one interval after this one
+			scd41_command_time = now_ms;
+			scd41_wait_time = scd41_periodic - SCD41_POLL_INTERVAL_MS;
+			scd41_state = SCD41_STATE_WAIT;
+		}
+		else
+		{
+			scd41_wait_time = 0;
+			scd41_state = SCD41_STATE_IDLE;
+		}
+		
+		if (!valid)
+		{
+			return 0; // Corrupted measurement, keep the last one
+		}
+		if (scd41_callback)
+		{
+			scd41_callback(last_co2, last_temperature, last_humidity);
+		}
+		return 1;
+		
+		case SCD41_STATE_STOPPING:
+		scd41_wait_time = 0;
+		scd41_state = SCD41_STATE_IDLE;
+		return 0;
+	}
+	
+	return 0;
+}
+
+/**
+ * @brief Get the execution time of a command
+ * @param command Command sent to the sensor
+ * @return Execution time in ms
+ */
+uint16_t scd41_get_execution_time(uint16_t command)
+{
+	switch (command)
+	{
+		case SCD41_COMMAND_START_PRERIODIC_MEASUREMENT:
+		return SCD41_EXECUTION_TIME_START_PERIODIC_MEASUREMENT_MS;
+		
+		case SCD41_COMMAND_READ_MEASUREMENT:
+		return SCD41_EXECUTION_TIME_READ_MEASUREMENT_MS;
+		
+		case SCD41_COMMAND_STOP_PRERIODIC_MEASUREMENT:
+		return SCD41_EXECUTION_TIME_STOP_PERIODIC_MEASUREMENT_MS;
+		
+		case SCD41_COMMAND_MEASURE_SINGLE_SHOT:
+		return SCD41_EXECUTION_TIME_MEASURE_SINGLE_SHOT_MS;
+		
+		case SCD41_COMMAND_GET_DATA_READY_STATUS:
+		return SCD41_EXECUTION_TIME_GET_DATA_READY_STATUS_MS;
+		
+		case SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT:
+		return SCD41_EXECUTION_TIME_START_LOW_POWER_PERIODIC_MEASUREMENT_MS;
+		
+		case SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY:
+		return SCD41_EXECUTION_TIME_MEASURE_SINGLE_SHOT_RHT_ONLY_MS;
+	}
+	return 1;
+}
+
 /**
  * @brief Write command and data to sensor
  * @param command Command to send
@@ -174,7 +447,7 @@ void scd41_sequence_write(uint16_t command, uint16_t data)
 	i2c_master_sendChar(command);
 	i2c_master_sendChar(data>>8);
 	i2c_master_sendChar(data);
-	i2c_master_sendChar(generate_checksum(data));
+	i2c_master_sendChar(scd41_generate_checksum(data));
 	i2c_master_stop();
 }
 
@@ -199,17 +472,52 @@ void scd41_sequence_send_command(uint16_t command)
  */
 void scd41_sequence_read(uint16_t command, uint16_t readData[], uint8_t length)
 {
-	// Start I2C communication in write mode
-	i2c_master_start();
-	i2c_master_sendAddress(SCD41_ADDRESS, 0x00);
+	// Send the command and release the bus
+	scd41_sequence_send_command(command);
 	
-	// Send command bytes
-	i2c_master_sendChar(command>>8);    // Upper byte
-	i2c_master_sendChar(command);       // Lower byte
+	// Wait exactly the execution time of the command
+	for (uint16_t ms = scd41_get_execution_time(command); ms > 0; ms--)
+	{
+		_delay_ms(1);
+	}
 	
-	_delay_ms(2);	
+	// Read the response
+	scd41_sequence_receive(readData, length);
+}
+
+/**
+ * @brief Send command to sensor without waiting for its execution
+ * @param command Command to send
+ * @param now_ms Current time in ms
+ */
+void scd41_sequence_request(uint16_t command, uint16_t now_ms)
+{
+	scd41_sequence_send_command(command);
+	scd41_command_time = now_ms;
+	scd41_wait_time = scd41_get_execution_time(command);
+}
+
+/**
+ * @brief Check whether the last command has been executed
+ * @param now_ms Current time in ms
+ * @return 1 if the sensor accepts the read phase or the next command, 0 otherwise
+ */
+uint8_t scd41_sequence_ready(uint16_t now_ms)
+{
+	return (uint16_t)(now_ms - scd41_command_time) >= scd41_wait_time;
+}
+
+/**
+ * @brief Read the response of the last command from sensor
+ * @param readData Array to store read data
+ * @param length Number of 16-bit words to read
+ * @return 1 if all checksums are valid, 0 otherwise
+ */
+uint8_t scd41_sequence_receive(uint16_t readData[], uint8_t length)
+{
+	uint8_t valid = 1;
 	
-	// Restart I2C in read mode
+	// Start I2C communication in read mode
 	i2c_master_start();
 	i2c_master_sendAddress(SCD41_ADDRESS, 0x01);
 	
@@ -234,19 +542,22 @@ void scd41_sequence_read(uint16_t command, uint16_t readData[], uint8_t length)
 		
 		// Process checksum if enabled
 		#ifdef SCD41_PROCESS_CHECKSUM
-		uint16_t
-		if (check_checksum(received_Data, received_Data_crc))
+		if (scd41_check_checksum(received_Data, received_Data_crc))
 		{
 			readData[data_index] = received_Data;          // Store valid data
 		}else
 		{
 			readData[data_index] = 0xFFFF;                // Store error value
+			valid = 0;
 		}
 		#else
+		(void)received_Data_crc;
 		readData[data_index] = received_Data;             // Store data without validation
 		#endif
 	}
 	
 	// End I2C communication
 	i2c_master_stop();
+	
+	return valid;
 }
\ No newline at end of file
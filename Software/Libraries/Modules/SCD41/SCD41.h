@@ -11,6 +11,8 @@
 
 
 #include "i2c_master.h"
+#include "SCD41_crc.h"
+#include "SCD41_convert.h"
 #include <util/delay.h>
 
 
@@ -19,13 +21,14 @@
 * @brief Enable checksum processing after measuring the data.
 *
 * @note: This will only affect incoming data as a checksum is always needed when data is send.
+* A word with a wrong checksum is stored as 0xFFFF. See SCD41_CRC_FULL_TABLE for the cost.
 *
-* To enable, uncomment the following line:
+* To disable, comment out the following line:
 * @code
 * #define SCD41_PROCESS_CHECKSUM
 * @endcode
 */
-//#define SCD41_PROCESS_CHECKSUM
+#define SCD41_PROCESS_CHECKSUM
 
 
 /**
@@ -83,6 +86,77 @@
  */
 #define SCD41_COMMAND_MEASURE_SINGLE_SHOT								0x219d
 
+/**
+ * @ingroup CommandAddresses
+ * 
+ * @def SCD41_COMMAND_GET_DATA_READY_STATUS
+ * 
+ * @brief The command to check whether a new measurement can be read.
+ * 
+ */
+#define SCD41_COMMAND_GET_DATA_READY_STATUS								0xe4b8
+
+/**
+ * @ingroup CommandAddresses
+ * 
+ * @def SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT
+ * 
+ * @brief The command to start a periodic measurement every 30 s.
+ * 
+ */
+#define SCD41_COMMAND_START_LOW_POWER_PERIODIC_MEASUREMENT				0x21ac
+
+/**
+ * @ingroup CommandAddresses
+ * 
+ * @def SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY
+ * 
+ * @brief The command to perform a single-shot measurement of temperature and humidity only.
+ * 
+ */
+#define SCD41_COMMAND_MEASURE_SINGLE_SHOT_RHT_ONLY						0x2196
+
+
+/**
+ * @defgroup ExecutionTimes Execution times of the commands
+ * Time in ms the sensor needs to process a command before the next command or the read phase.
+ * @{
+ */
+
+#define SCD41_EXECUTION_TIME_START_PERIODIC_MEASUREMENT_MS				0
+#define SCD41_EXECUTION_TIME_READ_MEASUREMENT_MS						1
+#define SCD41_EXECUTION_TIME_STOP_PERIODIC_MEASUREMENT_MS				500
+#define SCD41_EXECUTION_TIME_MEASURE_SINGLE_SHOT_MS						5000
+#define SCD41_EXECUTION_TIME_GET_DATA_READY_STATUS_MS					1
+#define SCD41_EXECUTION_TIME_START_LOW_POWER_PERIODIC_MEASUREMENT_MS	0
+#define SCD41_EXECUTION_TIME_MEASURE_SINGLE_SHOT_RHT_ONLY_MS			50
+
+/** @} */
+
+/**
+ * @def SCD41_PERIODIC_INTERVAL_MS
+ * @brief Time between two measurements in periodic measurement mode.
+ */
+#define SCD41_PERIODIC_INTERVAL_MS										5000
+
+/**
+ * @def SCD41_LOW_POWER_INTERVAL_MS
+ * @brief Time between two measurements in low power periodic measurement mode.
+ */
+#define SCD41_LOW_POWER_INTERVAL_MS										30000
+
+/**
+ * @def SCD41_POLL_INTERVAL_MS
+ * @brief Time between two data ready checks of `scd41_poll()` while a measurement is expected.
+ */
+#define SCD41_POLL_INTERVAL_MS											100
+
+/**
+ * @def SCD41_DATA_READY_MASK
+ * @brief Bits of the data ready status which are not 0 if a new measurement is available.
+ */
+#define SCD41_DATA_READY_MASK											0x07ff
+
 
 
 /**
@@ -128,6 +202,16 @@ float scd41_get_temperature();
 */
 uint16_t scd41_get_temperature_raw();
 
+/**
+ * @brief Get last measured temperature without floating point
+ * Gets the last measured temperature in hundredths of degrees C, e.g. 2315 for 23.15 degrees C.
+ * 
+ * @return int16_t temperature value in 0.01 degrees C
+ * @note This does not get the current measurement from the sensor. Use `read_measurement()` to get the most recent data.
+ * @ingroup BasicCommands
+*/
+int16_t scd41_get_temperature_centi();
+
 /**
  * @brief Get last measured humidity
  * Gets the last measured humidity in percent.
@@ -148,6 +232,16 @@ float scd41_get_humidity();
 */
 uint16_t scd41_get_humidity_raw();
 
+/**
+ * @brief Get last measured humidity without floating point
+ * Gets the last measured humidity in hundredths of percent, e.g. 4570 for 45.70 %.
+ * 
+ * @return uint16_t relative humidity value in 0.01 percent
+ * @note This does not get the current measurement from the sensor. Use `read_measurement()` to get the most recent data.
+ * @ingroup BasicCommands
+*/
+uint16_t scd41_get_humidity_centi();
+
 /**
  * @brief Start periodic measurement mode
  * 
@@ -183,4 +277,203 @@ void scd41_stop_periodic_measurement(uint8_t wait);
 */
 void scd41_measure_single_shot(uint8_t wait);
 
+/**
+ * @defgroup PowerModes Measurement modes and their budget
+ * Typical values of the datasheet at 3.3 V, rounded. Latency is the time from the command to readable data.
+ *
+ * | Mode                      | Command | Interval       | Latency | Average sensor current     |
+ * |---------------------------|---------|----------------|---------|----------------------------|
+ * | Periodic                  | 0x21b1  | 5 s            | 5 s     | 15 mA                      |
+ * | Low power periodic        | 0x21ac  | 30 s           | 30 s    | 3.2 mA                     |
+ * | Single shot               | 0x219d  | on demand      | 5 s     | 0.45 mA at one per 5 min   |
+ * | Single shot RHT only      | 0x2196  | on demand      | 50 ms   | about 1 % of a single shot |
+ *
+ * Single shots leave the sensor idle (about 0.2 mA) between measurements. RHT only skips the CO2
+ * measurement, the CO2 value then reads 0 and `scd41_get_co2()` keeps the last CO2 value.
+ * With the scheduler the MCU only has to wake for the I2C transfers, see `scd41_get_idle_time()`.
+ */
+
+/**
+* @brief Start low power periodic measurement mode
+*
+* Measures every 30 s instead of every 5 s.
+* @note To stop the measurements use the function `stop_periodic_measurement()`.
+* @ingroup PowerModes
+*/
+void scd41_start_low_power_periodic_measurement();
+
+/**
+* @brief Perform a single measurement of temperature and humidity only
+* @param wait If 1, waits 50ms for measurement
+* @ingroup PowerModes
+*/
+void scd41_measure_single_shot_rht_only(uint8_t wait);
+
+
+/**
+ * @defgroup Scheduler Non-blocking Measurements
+ * A set of functions to measure without waiting for the sensor.
+ * The request functions only select the next step, `scd41_poll()` sends the commands
+ * and checks the data ready status once the execution time of the last command has passed.
+ */
+
+/**
+* @brief Set the function to call when a new measurement was read
+* @param callback Called by `scd41_poll()` with the raw CO2, temperature and humidity, NULL for none.
+* @ingroup Scheduler
+*/
+void scd41_set_callback(void (*callback)(uint16_t co2, uint16_t temperature_raw, uint16_t humidity_raw));
+
+/**
+* @brief Request periodic measurement mode
+* @note A new measurement is available every 5 s.
+* @ingroup Scheduler
+*/
+void scd41_request_periodic_measurement();
+
+/**
+* @brief Request a single measurement
+* @note The measurement is available after 5 s.
+* @ingroup Scheduler
+*/
+void scd41_request_single_shot();
+
+/**
+* @brief Request low power periodic measurement mode
+* @note A new measurement is available every 30 s.
+* @ingroup Scheduler
+*/
+void scd41_request_low_power_periodic_measurement();
+
+/**
+* @brief Request a single measurement of temperature and humidity only
+* @note The measurement is available after 50 ms, CO2 is not updated.
+* @ingroup Scheduler
+*/
+void scd41_request_single_shot_rht_only();
+
+/**
+* @brief Request to stop periodic measurement mode
+* @note The sensor accepts new commands 500 ms after the request was sent.
+* @ingroup Scheduler
+*/
+void scd41_request_stop();
+
+/**
+* @brief Check whether `scd41_poll()` is waiting for the sensor
+* @return 1 if a command or measurement is pending, 0 if idle.
+* @ingroup Scheduler
+*/
+uint8_t scd41_is_busy();
+
+/**
+* @brief Get the time until `scd41_poll()` has something to do
+*
+* The MCU may sleep this long, e.g. in a timer-woken sleep mode, before the next poll.
+*
+* @param now_ms The current time in milliseconds.
+* @return Time in ms until the next step, 0 if it is due, 0xFFFF if idle.
+* @ingroup Scheduler
+*/
+uint16_t scd41_get_idle_time(uint16_t now_ms);
+
+/**
+* @brief Continue a measurement without blocking
+*
+* Call this as often as possible from the main loop. Every call does at most one step and returns immediately.
+* A new measurement is stored for the getters and passed to the callback.
+*
+* @param now_ms The current time in milliseconds, e.g. from a timer. It may overflow.
+* @return 1 if a new measurement was read, 0 otherwise.
+* @ingroup Scheduler
+*/
+uint8_t scd41_poll(uint16_t now_ms);
+
+
+/**
+ * @defgroup Sequences I2C Sequences
+ * Low level transfers to the sensor.
+ */
+
+/**
+* @brief Get the execution time of a command
+* @param command Command sent to the sensor
+* @return Time in ms until the sensor accepts the next command or the read phase.
+* @ingroup Sequences
+*/
+uint16_t scd41_get_execution_time(uint16_t command);
+
+/**
+* @brief Write command and data to sensor
+* @param command Command to send
+* @param data Data to write
+* @ingroup Sequences
+*/
+void scd41_sequence_write(uint16_t command, uint16_t data);
+
+/**
+* @brief Send command to sensor
+* @param command Command to send
+* @ingroup Sequences
+*/
+void scd41_sequence_send_command(uint16_t command);
+
+/**
+* @brief Read data from sensor
+* @note Blocks for the execution time of the command, the bus is released meanwhile.
+* @param command Command to send
+* @param readData Array to store read data
+* @param length Number of 16-bit words to read
+* @ingroup Sequences
+*/
+void scd41_sequence_read(uint16_t command, uint16_t readData[], uint8_t length);
+
+/**
+* @brief Send command to sensor without waiting for its execution
+*
+* The bus is released after the command, so other devices can be accessed while the sensor
+* processes it. Call `scd41_sequence_receive()` once `scd41_sequence_ready()` returns 1.
+* `scd41_poll()` uses the same timing, do not mix both while the scheduler is busy.
+*
+* @param command Command to send
+* @param now_ms The current time in milliseconds, e.g. from a timer. It may overflow.
+* @ingroup Sequences
+*/
+void scd41_sequence_request(uint16_t command, uint16_t now_ms);
+
+/**
+* @brief Check whether the last command has been executed
+* @param now_ms The current time in milliseconds.
+* @return 1 if the execution time of the command sent with `scd41_sequence_request()` has passed, 0 otherwise
+* @ingroup Sequences
+*/
+uint8_t scd41_sequence_ready(uint16_t now_ms);
+
+/**
+* @brief Read the response of the last command from sensor
+* @note Only call this after the execution time of the command has passed.
+* @param readData Array to store read data
+* @param length Number of 16-bit words to read
+* @return 1 if all checksums are valid or not processed, 0 otherwise
+* @ingroup Sequences
+*/
+uint8_t scd41_sequence_receive(uint16_t readData[], uint8_t length);
+
+/**
+* @brief Generate CRC8 checksum for 16-bit value
+* @param value Value to generate checksum for
+* @return CRC8 checksum
+* @ingroup Sequences
+*/
+uint8_t scd41_generate_checksum(uint16_t value);
+
+/**
+* @brief Validate checksum against 16-bit value
+* @param value Value to validate
+* @param checksum Expected checksum
+* @return 1 if valid, 0 if invalid
+* @ingroup Sequences
+*/
+uint8_t scd41_check_checksum(uint16_t value, uint8_t checksum);
+
 #endif /* SCD41_H_ */
\ No newline at end of file
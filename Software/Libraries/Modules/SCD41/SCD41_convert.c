@@ -0,0 +1,30 @@
+/*
+* SCD41_convert.c
+*
+* Created: 19.10.2026 12:03:10
+*/
+
+#include "SCD41_convert.h"
+
+/*
+* Division by 65535 without a divide:
+* x / 65535 = (x + x / 65535) / 65536, and x >> 16 stands in for x / 65535
+* inside the bracket, off by less than 2 for x below 2^32.
+* Adding 32768 before the final shift rounds to nearest. The test over all
+* 65536 raw values shows the result is exact for both scales.
+*/
+static uint16_t scd41_scale(uint16_t scale, uint16_t raw)
+{
+	uint32_t x = (uint32_t)scale * raw;		// At most 17500 * 65535, fits with the additions below
+	return (uint16_t)((x + (x >> 16) + 32768) >> 16);
+}
+
+int16_t scd41_convert_temperature_centi(uint16_t raw)
+{
+	return (int16_t)scd41_scale(17500, raw) - 4500;
+}
+
+uint16_t scd41_convert_humidity_centi(uint16_t raw)
+{
+	return scd41_scale(10000, raw);
+}
@@ -0,0 +1,33 @@
+/*
+* SCD41_convert.h
+*
+* Integer conversion of the raw SCD41 temperature and humidity
+* The results equal the datasheet formulas rounded to the nearest
+* hundredth for every raw value, see test_host.c.
+*
+* Created: 19.10.2026 12:02:47
+*/
+
+
+#ifndef SCD41_CONVERT_H_
+#define SCD41_CONVERT_H_
+
+
+#include <stdint.h>
+
+
+/**
+* @brief Convert a raw temperature
+* @param raw Raw temperature from the sensor
+* @return Temperature in 0.01 degrees C, round(-4500 + 17500 * raw / 65535)
+*/
+int16_t scd41_convert_temperature_centi(uint16_t raw);
+
+/**
+* @brief Convert a raw humidity
+* @param raw Raw humidity from the sensor
+* @return Relative humidity in 0.01 percent, round(10000 * raw / 65535)
+*/
+uint16_t scd41_convert_humidity_centi(uint16_t raw);
+
+#endif /* SCD41_CONVERT_H_ */
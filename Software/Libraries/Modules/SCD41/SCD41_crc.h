@@ -0,0 +1,75 @@
+/*
+* SCD41_crc.h
+*
+* CRC-8 of the Sensirion I2C protocol (polynomial 0x31, init 0xFF, no final XOR)
+* Every 16-bit word sent to or read from the SCD41 is followed by this checksum.
+*
+* Created: 19.10.2026 11:05:13
+*/
+
+
+#ifndef SCD41_CRC_H_
+#define SCD41_CRC_H_
+
+
+#include <stdint.h>
+
+
+/**
+* @def SCD41_CRC_FULL_TABLE
+* @brief Use the 256-byte table for the checksum instead of the 16-byte one.
+*
+* @note: The only exact difference is the size of the table in flash:
+* - bitwise:           no table
+* - 16-byte table:     16 bytes of table (default)
+* - 256-byte table:    256 bytes of table
+*
+* Code size and cycle counts have not been measured on the ATmega16A. The bitwise variant loops eight times per byte,
+* the 16-byte table twice and the 256-byte table once, so the larger tables should be faster.
+* Receiving one word with its checksum takes 27 bit times, about 810 cycles at 400 kHz I2C and 12 MHz.
+* The 16-byte table is the default because it spends little flash, not because it was benchmarked as the best choice.
+* Only the selected variant is linked if unused sections are removed (-ffunction-sections, --gc-sections).
+*
+* To enable, uncomment the following line:
+* @code
+* #define SCD41_CRC_FULL_TABLE
+* @endcode
+*/
+//#define SCD41_CRC_FULL_TABLE
+
+
+/**
+* @def SCD41_CRC_POLYNOMIAL
+* @brief Polynomial of the checksum, x^8 + x^5 + x^4 + 1.
+*/
+#define SCD41_CRC_POLYNOMIAL		0x31
+
+/**
+* @def SCD41_CRC_INIT
+* @brief Start value of the checksum.
+*/
+#define SCD41_CRC_INIT				0xff
+
+
+/**
+* @brief Calculate the checksum bit by bit
+* @param value 16-bit word, most significant byte first on the bus
+* @return CRC-8 checksum
+*/
+uint8_t scd41_crc_bitwise(uint16_t value);
+
+/**
+* @brief Calculate the checksum with a 256-byte table in flash
+* @param value 16-bit word, most significant byte first on the bus
+* @return CRC-8 checksum
+*/
+uint8_t scd41_crc_byte_table(uint16_t value);
+
+/**
+* @brief Calculate the checksum with a 16-byte table in flash, four bits per step
+* @param value 16-bit word, most significant byte first on the bus
+* @return CRC-8 checksum
+*/
+uint8_t scd41_crc_nibble_table(uint16_t value);
+
+#endif /* SCD41_CRC_H_ */
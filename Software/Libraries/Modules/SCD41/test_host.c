@@ -0,0 +1,102 @@
+/*
+* test_host.c
+*
+* Host test of the SCD41 checksum and conversions. Compares every checksum
+* variant with the bitwise reference for all 65536 words and measures the
+* time per word. Compares the integer conversions with the exact rounded
+* datasheet formulas for all 65536 raw values.
+*
+* Build and run on Linux:
+*     gcc -O2 -o test_host test_host.c SCD41_crc.c SCD41_convert.c
+*     ./test_host
+*
+* Created: 19.10.2026 11:41:07
+*/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "SCD41_crc.h"
+#include "SCD41_convert.h"
+
+#define BENCHMARK_ROUNDS 200
+
+static int failures = 0;
+
+static void expect(int condition, const char *message)
+{
+	if (!condition)
+	{
+		printf("FAIL: %s\n", message);
+		failures++;
+	}
+}
+
+static double benchmark(uint8_t (*crc)(uint16_t))
+{
+	volatile uint8_t sink = 0;
+	clock_t start = clock();
+	for (int round = 0; round < BENCHMARK_ROUNDS; round++)
+	{
+		for (uint32_t value = 0; value < 0x10000; value++)
+		{
+			sink ^= crc((uint16_t)value);
+		}
+	}
+	(void)sink;
+	return (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / (BENCHMARK_ROUNDS * 65536.0);
+}
+
+static void test_crc()
+{
+	// Example of the datasheet
+	expect(scd41_crc_bitwise(0xBEEF) == 0x92, "bitwise CRC of 0xBEEF is 0x92");
+	expect(scd41_crc_byte_table(0xBEEF) == 0x92, "byte table CRC of 0xBEEF is 0x92");
+	expect(scd41_crc_nibble_table(0xBEEF) == 0x92, "nibble table CRC of 0xBEEF is 0x92");
+	
+	uint32_t byte_errors = 0;
+	uint32_t nibble_errors = 0;
+	for (uint32_t value = 0; value < 0x10000; value++)
+	{
+		uint8_t reference = scd41_crc_bitwise((uint16_t)value);
+		byte_errors += scd41_crc_byte_table((uint16_t)value) != reference;
+		nibble_errors += scd41_crc_nibble_table((uint16_t)value) != reference;
+	}
+	expect(byte_errors == 0, "byte table matches bitwise for all words");
+	expect(nibble_errors == 0, "nibble table matches bitwise for all words");
+	printf("CRC: %u byte table and %u nibble table mismatches in 65536 words\n", byte_errors, nibble_errors);
+	
+	printf("CRC time per word on this host: bitwise %.1f ns, byte table %.1f ns, nibble table %.1f ns\n",
+		benchmark(scd41_crc_bitwise), benchmark(scd41_crc_byte_table), benchmark(scd41_crc_nibble_table));
+}
+
+// round(numerator / 65535) for a non-negative numerator
+static int64_t divide_rounded(int64_t numerator)
+{
+	return (2 * numerator + 65535) / (2 * 65535);
+}
+
+static void test_convert()
+{
+	uint32_t temperature_errors = 0;
+	uint32_t humidity_errors = 0;
+	for (uint32_t raw = 0; raw < 0x10000; raw++)
+	{
+		temperature_errors += scd41_convert_temperature_centi((uint16_t)raw) != -4500 + divide_rounded(17500LL * raw);
+		humidity_errors += scd41_convert_humidity_centi((uint16_t)raw) != divide_rounded(10000LL * raw);
+	}
+	expect(temperature_errors == 0, "temperature matches -4500 + 17500 * raw / 65535 for all raw values");
+	expect(humidity_errors == 0, "humidity matches 10000 * raw / 65535 for all raw values");
+	expect(scd41_convert_temperature_centi(0) == -4500 && scd41_convert_temperature_centi(0xFFFF) == 13000, "temperature range");
+	expect(scd41_convert_humidity_centi(0) == 0 && scd41_convert_humidity_centi(0xFFFF) == 10000, "humidity range");
+	printf("Conversion: %u temperature and %u humidity mismatches in 65536 raw values\n", temperature_errors, humidity_errors);
+}
+
+int main()
+{
+	test_crc();
+	test_convert();
+	
+	printf(failures ? "%d FAILED\n" : "All tests passed\n", failures);
+	return failures != 0;
+}